@@ -0,0 +1,338 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/Array.h"
+#include "../include/Square.h"
+#include "../include/Rectangle.h"
+#include "../include/Trapezoid.h"
+#include "../include/PackedFigures.h"
+#include "../include/Rasterizer.h"
+#include "../include/OverlapGraph.h"
+#include "../include/ShardedFigures.h"
+#include "../include/CenterClustering.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Текущий VmRSS процесса в килобайтах.
+static long residentKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.rfind("VmRSS:", 0) == 0) return std::stol(line.substr(6));
+    return 0;
+}
+
+static std::shared_ptr<Figure<double>> makeSquare(double x, double y, double side) {
+    auto s = std::make_shared<Square<double>>();
+    std::istringstream iss(std::to_string(x) + " " + std::to_string(y) + " "
+        + std::to_string(x + side) + " " + std::to_string(y) + " "
+        + std::to_string(x + side) + " " + std::to_string(y + side) + " "
+        + std::to_string(x) + " " + std::to_string(y + side));
+    iss >> *s;
+    return s;
+}
+
+// --- SNAPSHOT: читатели агрегируют снимки, пока писатель добавляет и удаляет ---
+static void benchSnapshots(size_t n, int readers) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    for (size_t i = 0; i < n; ++i) figures.add(makeSquare(i, 0, 1 + i % 7));
+
+    std::atomic<bool> done{false};
+    std::atomic<size_t> reads{0};
+    std::atomic<std::shared_ptr<const ArraySnapshot<std::shared_ptr<Figure<double>>>>> published{
+        std::make_shared<const ArraySnapshot<std::shared_ptr<Figure<double>>>>(figures.snapshot())};
+
+    std::vector<std::thread> pool;
+    for (int r = 0; r < readers; ++r) {
+        pool.emplace_back([&] {
+            double sink = 0;
+            while (!done.load()) {
+                auto snap = published.load();
+                sink += snap->totalSurface();
+                reads.fetch_add(1);
+            }
+            if (sink < 0) std::cout << sink;
+        });
+    }
+
+    auto start = Clock::now();
+    size_t writes = 0;
+    for (size_t i = 0; i < n; ++i, writes += 2) {
+        figures.add(makeSquare(i, 1, 2));
+        figures.remove(figures.getSize() - 1 - i % 16);
+        if (i % 64 == 0)
+            published.store(std::make_shared<const ArraySnapshot<std::shared_ptr<Figure<double>>>>(figures.snapshot()));
+    }
+    double elapsed = secondsSince(start);
+    done = true;
+    for (auto& t : pool) t.join();
+
+    std::cout << "snapshot n=" << n << " readers=" << readers
+              << " writes/s=" << writes / elapsed
+              << " full_reads/s=" << reads.load() / elapsed << "\n";
+}
+
+// --- SNAPSHOT+STATS: снимок перед каждой записью, с агрегатами и без ---
+static void benchStatsSnapshots(size_t n, bool stats) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    for (size_t i = 0; i < n; ++i) figures.add(makeSquare(double(i % 1000), double(i / 1000), 1 + i % 7));
+    if (stats) figures.trackStats();
+    auto extra = makeSquare(0, 0, 3);
+
+    const size_t writes = 2000;
+    double sink = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < writes; ++i) {
+        auto snap = figures.snapshot();
+        figures.add(extra);
+        if (stats) sink += snap.getStats().totalSurface();
+    }
+    double elapsed = secondsSince(start);
+
+    std::cout << "snapshot_write n=" << n << " stats=" << (stats ? "on" : "off")
+              << " us_per_snapshot_and_add=" << elapsed / writes * 1e6
+              << (stats ? " max=" + std::to_string(figures.getStats().maxSurface()) : "")
+              << (sink < 0 ? "!" : "") << "\n";
+}
+
+// --- PRECISION: totalSurface по фигурам-объектам и по плоскому хранилищу ---
+template <class T>
+static void benchPrecision(size_t n, int passes) {
+    Array<Rectangle<T>> figures;
+    for (size_t i = 0; i < n; ++i) {
+        Rectangle<T> r;
+        double x = i % 1000, y = i / 1000, w = 1 + i % 5, h = 1 + i % 3;
+        std::istringstream iss(std::to_string(x) + " " + std::to_string(y) + " "
+            + std::to_string(x + w) + " " + std::to_string(y) + " "
+            + std::to_string(x + w) + " " + std::to_string(y + h) + " "
+            + std::to_string(x) + " " + std::to_string(y + h));
+        iss >> r;
+        figures.add(std::move(r));
+    }
+    PackedFigures<T> packed = PackedFigures<T>::from(figures);
+
+    auto start = Clock::now();
+    double sink = 0;
+    for (int p = 0; p < passes; ++p) sink += figures.totalSurface();
+    double objectTime = secondsSince(start);
+
+    start = Clock::now();
+    double packedSink = 0;
+    for (int p = 0; p < passes; ++p) packedSink += packed.totalSurface();
+    double packedTime = secondsSince(start);
+
+    std::cout << "precision coord=" << (sizeof(T) == 4 ? "float" : "double") << " n=" << n
+              << " object_bytes/fig=" << figures.memoryReport().total() / n
+              << " packed_bytes/fig=" << packed.bytes() / n
+              << " object_figures/s=" << n * passes / objectTime
+              << " packed_figures/s=" << n * passes / packedTime
+              << " total=" << std::setprecision(17) << sink / passes
+              << " packed_total=" << packedSink / passes << std::setprecision(6) << "\n";
+}
+
+// --- RASTER: покрытие сетки при разных разрешениях, числе фигур и потоков ---
+static void benchRaster(size_t n, size_t resolution, unsigned threads) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    double world = 1000.0;
+    for (size_t i = 0; i < n; ++i)
+        figures.add(makeSquare(double(i * 7919 % 997), double(i * 104729 % 991), 1 + i % 13));
+
+    RasterGrid grid{0, 0, world / resolution, resolution, resolution};
+    std::vector<uint32_t> counts(resolution * resolution);
+    std::vector<float> fraction(resolution * resolution);
+    Rasterizer raster(grid, threads);
+
+    auto start = Clock::now();
+    raster.coverageCounts(figures, counts);
+    double countsTime = secondsSince(start);
+
+    start = Clock::now();
+    raster.coverageFraction(figures, fraction, 4);
+    double fractionTime = secondsSince(start);
+
+    std::cout << "raster n=" << n << " grid=" << resolution << "x" << resolution
+              << " threads=" << threads
+              << " counts_ms=" << countsTime * 1e3
+              << " fraction_ms=" << fractionTime * 1e3 << "\n";
+}
+
+// --- INGEST: operator>> с исключениями против tryRead на грязных данных ---
+static void benchIngest(size_t n, int invalidPercent) {
+    std::vector<std::string> records;
+    for (size_t i = 0; i < n; ++i) {
+        double x = double(i % 500), y = double(i / 500);
+        bool invalid = int(i * 7 % 100) < invalidPercent;
+        std::ostringstream oss;
+        oss << x << " " << y << " " << x + 2 << " " << y << " " << x + 2 << " " << y + (invalid ? 3 : 2)
+            << " " << x << " " << y + 2;
+        records.push_back(oss.str());
+    }
+
+    auto start = Clock::now();
+    Array<std::shared_ptr<Figure<double>>> thrown;
+    for (const auto& rec : records) {
+        auto fig = std::make_shared<Square<double>>();
+        std::istringstream iss(rec);
+        try {
+            iss >> *fig;
+            thrown.add(fig);
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    double throwing = secondsSince(start);
+
+    start = Clock::now();
+    Array<std::shared_ptr<Figure<double>>> coded;
+    for (const auto& rec : records) {
+        auto fig = std::make_shared<Square<double>>();
+        std::istringstream iss(rec);
+        if (fig->tryRead(iss) == FigureError::None) coded.add(fig);
+    }
+    double nonThrowing = secondsSince(start);
+
+    start = Clock::now();
+    double checked = 0;
+    for (int pass = 0; pass < 20; ++pass)
+        for (size_t i = 0; i < coded.getSize(); ++i) checked += coded[i]->surface();
+    double checkedTime = secondsSince(start);
+
+    start = Clock::now();
+    double unchecked = 0;
+    for (int pass = 0; pass < 20; ++pass)
+        coded.forEach([&](const std::shared_ptr<Figure<double>>& f) { unchecked += f->surface(); });
+    double uncheckedTime = secondsSince(start);
+
+    std::cout << "ingest n=" << n << " invalid=" << invalidPercent << "%"
+              << " accepted=" << coded.getSize() << "/" << thrown.getSize()
+              << " throwing_rec/s=" << n / throwing
+              << " try_rec/s=" << n / nonThrowing
+              << " checked_ms=" << checkedTime * 1e3
+              << " foreach_ms=" << uncheckedTime * 1e3
+              << (checked == unchecked ? "" : " MISMATCH") << "\n";
+}
+
+// --- CLUSTER: граф перекрытий и компоненты связности при разном числе потоков ---
+static void benchOverlap(size_t n, unsigned threads) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    double world = std::sqrt(double(n)) * 4;
+    for (size_t i = 0; i < n; ++i)
+        figures.add(makeSquare(std::fmod(i * 7.31, world), std::fmod(i * 3.17 + i / 97.0, world), 1 + i % 4));
+
+    auto start = Clock::now();
+    ClusterResult result = OverlapGraph(threads).cluster(figures, false);
+    double elapsed = secondsSince(start);
+
+    std::cout << "overlap n=" << n << " threads=" << threads
+              << " clusters=" << result.clusters.size()
+              << " ms=" << elapsed * 1e3
+              << " figures/s=" << n / elapsed << "\n";
+}
+
+// --- SHARDED: scatter/gather по процессам-воркерам против одного процесса ---
+static void benchSharded(size_t n, size_t shardCount) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    for (size_t i = 0; i < n; ++i) figures.add(makeSquare(double(i % 1000), double(i / 1000), 1 + i % 9));
+
+    ShardedFigures sharded(shardCount);
+    long rssBefore = residentKb();
+    auto start = Clock::now();
+    sharded.addAll(figures);
+    double load = secondsSince(start);
+
+    start = Clock::now();
+    double total = 0;
+    for (int pass = 0; pass < 10; ++pass) total += sharded.totalSurface();
+    double totalTime = secondsSince(start) / 10;
+
+    start = Clock::now();
+    auto top = sharded.topK(100);
+    auto region = sharded.inRegion(100, 10, 300, 50);
+    double queries = secondsSince(start);
+    long coordinatorGrowth = residentKb() - rssBefore;
+
+    start = Clock::now();
+    double local = figures.totalSurface();
+    double localTime = secondsSince(start);
+
+    std::cout << "sharded n=" << n << " shards=" << shardCount
+              << " load_ms=" << load * 1e3
+              << " total_ms=" << totalTime * 1e3
+              << " single_process_total_ms=" << localTime * 1e3
+              << " topk_region_ms=" << queries * 1e3
+              << " region=" << region.size()
+              << " coordinator_rss_growth_kb=" << coordinatorGrowth
+              << (std::abs(total / 10 - local) < 1e-6 * local ? "" : " MISMATCH") << "\n";
+}
+
+// --- KMEANS: k-means и сеточная кластеризация центров от 1e5 до maxPoints точек ---
+static void benchClustering(size_t n, unsigned threads) {
+    CenterBuffer points;
+    points.reserve(n);
+    std::mt19937_64 rng(n);
+    std::normal_distribution<double> noise(0.0, 20.0);
+    for (size_t i = 0; i < n; ++i) {
+        double hx = double(i % 16 / 4) * 250, hy = double(i % 4) * 250;
+        points.add(hx + noise(rng), hy + noise(rng), 1.0);
+    }
+
+    auto start = Clock::now();
+    ClusteringResult km = KMeans(16, threads, 20).run(points);
+    double kmTime = secondsSince(start);
+
+    start = Clock::now();
+    ClusteringResult grid = GridClustering(10.0, 4, threads).run(points);
+    double gridTime = secondsSince(start);
+
+    std::cout << "kmeans n=" << n << " threads=" << threads
+              << " k=16 iterations=" << km.iterations << " converged=" << km.converged
+              << " kmeans_ms=" << kmTime * 1e3
+              << " points_iter/s=" << n * km.iterations / kmTime
+              << " grid_clusters=" << grid.centroids.size()
+              << " grid_ms=" << gridTime * 1e3 << "\n";
+}
+
+int main(int argc, char** argv) {
+    if (ShardedFigures::runWorkerFromArgs(argc, argv)) return 0;
+    std::string only = argc > 1 ? argv[1] : "";
+
+    if (only.empty() || only == "snapshot") {
+        for (int readers : {0, 1, 4}) benchSnapshots(20000, readers);
+        for (bool stats : {false, true}) benchStatsSnapshots(200000, stats);
+    }
+    if (only.empty() || only == "precision") {
+        benchPrecision<float>(200000, 20);
+        benchPrecision<double>(200000, 20);
+    }
+    if (only.empty() || only == "raster") {
+        for (size_t n : {1000, 20000})
+            for (size_t resolution : {512, 2048})
+                for (unsigned threads : {1u, 4u}) benchRaster(n, resolution, threads);
+    }
+    if (only.empty() || only == "ingest") {
+        for (int invalid : {0, 10, 50}) benchIngest(100000, invalid);
+    }
+    if (only.empty() || only == "overlap") {
+        for (size_t n : {10000, 200000})
+            for (unsigned threads : {1u, 2u, 4u, 8u}) benchOverlap(n, threads);
+    }
+    if (only.empty() || only == "sharded") {
+        for (size_t shardCount : {1, 2, 4}) benchSharded(1000000, shardCount);
+    }
+    if (only.empty() || only == "kmeans") {
+        // 1e8 точек требуют около 5 ГБ: передайте предел вторым аргументом.
+        size_t maxPoints = argc > 2 ? std::stoull(argv[2]) : 10000000;
+        for (size_t n = 100000; n <= maxPoints; n *= 10)
+            for (unsigned threads : {1u, 4u}) benchClustering(n, threads);
+    }
+}
@@ -5,8 +5,15 @@
 #include <memory>
 #include <stdexcept>
 #include <iomanip>
+#include <atomic>
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "Figure.h"
+#include "ArrayStats.h"
+#include "MemoryReport.h"
 
 template <typename>
 struct is_shared_ptr : std::false_type {};
@@ -14,86 +21,270 @@ struct is_shared_ptr : std::false_type {};
 template <typename U>
 struct is_shared_ptr<std::shared_ptr<U>> : std::true_type {};
 
-template <class T>
+template <class T, class Alloc = std::allocator<T>>
+class ArraySnapshot;
+
+// Элементы хранятся чанками по ChunkSize штук. Таблица чанков и сами чанки
+// разделяются между копиями Array (и снимками) и копируются только при записи,
+// поэтому копия массива стоит O(1), а писатель дублирует лишь затронутые чанки.
+// Alloc используется для чанков и таблицы чанков; например, CountingAllocator
+// позволяет посчитать выделения памяти самим массивом.
+template <class T, class Alloc = std::allocator<T>>
 class Array {
 public:
-    Array() : size(0), capacity(4) {
-        data = std::make_shared<T[]>(capacity);
+    static constexpr size_t ChunkSize = 64;
+
+    Array() : Array(Alloc()) {}
+
+    explicit Array(const Alloc& alloc) : size(0), capacity(ChunkSize), slots(4), alloc(alloc) {
+        chunks = newTable(slots);
+        chunks[0] = newChunk();
+    }
+
+    // Копия разделяет чанки с оригиналом (O(1)); перемещённый массив остаётся пустым.
+    // Чанки, на элементы которых выданы изменяемые ссылки, копируются сразу:
+    // запись по такой ссылке не должна быть видна в копии.
+    Array(const Array& other)
+        : chunks(other.chunks), size(other.size), capacity(other.capacity), slots(other.slots),
+          version(other.version), stats(other.stats), alloc(other.alloc) {
+        if (other.leaked.empty()) return;
+        auto table = newTable(slots);
+        for (size_t c = 0; c < slots; ++c) table[c] = other.chunks[c];
+        for (size_t c = 0; c < other.leaked.size(); ++c)
+            if (other.leaked[c]) table[c] = cloneChunk(other.chunks[c]);
+        chunks = std::move(table);
+    }
+
+    Array& operator=(const Array& other) {
+        if (this != &other) *this = Array(other);
+        return *this;
+    }
+
+    Array(Array&& other) noexcept
+        : chunks(std::move(other.chunks)), size(std::exchange(other.size, 0)),
+          capacity(std::exchange(other.capacity, 0)), slots(std::exchange(other.slots, 0)),
+          version(other.version), stats(std::move(other.stats)), leaked(std::move(other.leaked)),
+          alloc(other.alloc) {}
+
+    Array& operator=(Array&& other) noexcept {
+        if (this == &other) return *this;
+        chunks = std::move(other.chunks);
+        size = std::exchange(other.size, 0);
+        capacity = std::exchange(other.capacity, 0);
+        slots = std::exchange(other.slots, 0);
+        version = other.version;
+        stats = std::move(other.stats);
+        leaked = std::move(other.leaked);
+        alloc = other.alloc;
+        return *this;
     }
 
     template <typename U>
     requires (!std::is_pointer_v<T> && !is_shared_ptr<T>::value)
     void add(const U& fig) {
         if (size >= capacity) resize();
-        data[size++] = fig;
+        writable(size++) = fig;
+        trackAdded();
     }
 
     template <typename U>
     requires (!std::is_pointer_v<T> && !is_shared_ptr<T>::value)
     void add(U&& fig) {
         if (size >= capacity) resize();
-        data[size++] = std::move(fig);
+        writable(size++) = std::forward<U>(fig);
+        trackAdded();
     }
 
     template <typename U>
     requires is_shared_ptr<T>::value
     void add(U fig) {
         if (size >= capacity) resize();
-        data[size++] = std::move(fig);
+        writable(size++) = std::move(fig);
+        trackAdded();
     }
 
     void remove(size_t index) {
         if (index >= size) throw std::out_of_range("Invalid out of range");
-        for (size_t i = index; i < size - 1; ++i) data[i] = std::move(data[i + 1]);
+        trackRemoved(index);
+        ++version;
+        leaked.clear();
+        for (size_t c = index / ChunkSize; c <= (size - 1) / ChunkSize; ++c) writableChunk(c);
+        for (size_t i = index; i < size - 1; ++i) slot(i) = std::move(slot(i + 1));
+        slot(size - 1) = T{};
         --size;
     }
 
+    // Замена элемента с обновлением агрегатов. Изменение через operator[]
+    // агрегаты не видят (remove вычтет прежний вклад элемента), поэтому
+    // при включённых stats используйте set().
+    template <typename U>
+    void set(size_t index, U&& fig) {
+        if (index >= size) throw std::out_of_range("Index out of range");
+        writable(index) = std::forward<U>(fig);
+        trackReplaced(index);
+    }
+
+    // Изменяемая ссылка действительна до следующего add/remove/set. Запись
+    // через неё не меняет версию и не видна снимкам, сделанным после её выдачи:
+    // до следующего изменения массива каждый снимок копирует такие чанки.
+    // Для чтения используйте константную перегрузку (через const-ссылку на
+    // массив) или forEach — они чанки не помечают.
     T& operator[](size_t index) {
         if (index >= size) throw std::out_of_range("Index out of range");
-        return data[index];
+        return exposed(index);
     }
 
     const T& operator[](size_t index) const {
         if (index >= size) throw std::out_of_range("Index out of range");
-        return data[index];
+        return cell(index);
+    }
+
+    // Без проверки границ для внутренних циклов: индекс должен быть < getSize().
+    // Быстрый путь — константная перегрузка и forEach. Изменяемая перегрузка
+    // работает как operator[]: первое обращение к чанку проверяет, не разделён
+    // ли он со снимком, последующие до add/remove/set сразу отдают слот.
+    const T& unchecked(size_t index) const {
+        return cell(index);
+    }
+
+    T& unchecked(size_t index) {
+        return exposed(index);
+    }
+
+    // Обход по чанкам без проверок границ и без копирования при записи.
+    template <class F>
+    void forEach(F&& f) const {
+        for (size_t c = 0; c * ChunkSize < size; ++c) {
+            const T* chunk = chunks[c].get();
+            size_t end = std::min(ChunkSize, size - c * ChunkSize);
+            for (size_t i = 0; i < end; ++i) f(chunk[i]);
+        }
+    }
+
+    // Добавление без исключений: фигура проверяется и при ошибке не добавляется.
+    template <typename U>
+    requires FigureLike<T>
+    FigureError tryAdd(U&& fig) {
+        if constexpr (requires { fig == nullptr; }) {
+            if (fig == nullptr) return FigureError::Empty;
+        }
+        FigureError error = figureOf(fig).check();
+        if (error != FigureError::None) return error;
+        add(std::forward<U>(fig));
+        return FigureError::None;
+    }
+
+    // Неизменяемый снимок текущего состояния. Стоит O(1), если после последнего
+    // add/remove/set не выдавались изменяемые ссылки (неконстантные operator[]
+    // и unchecked); иначе O(slots + ChunkSize на каждый помеченный чанк).
+    // Снимок можно передать в другой поток: последующие изменения массива его
+    // не затрагивают.
+    ArraySnapshot<T, Alloc> snapshot() const {
+        return ArraySnapshot<T, Alloc>(*this);
+    }
+
+    // Включает инкрементальные агрегаты: один полный проход сейчас, далее O(1)
+    // на add/set и на чтение сумм, O(n / ChunkSize) на min/max; remove, как и
+    // сам сдвиг, O(n).
+    void trackStats() requires FigureLike<T> {
+        auto fresh = std::make_shared<ArrayStats>();
+        for (size_t i = 0; i < size; ++i) {
+            if (present(cell(i))) fresh->insert(figureOf(cell(i)));
+            else fresh->insertEmpty();
+        }
+        stats = std::move(fresh);
+    }
+
+    bool hasStats() const {
+        return stats != nullptr;
+    }
+
+    const ArrayStats& getStats() const {
+        if (!stats) throw std::logic_error("Stats are not tracked for this array");
+        return *stats;
+    }
+
+    // Оценка занимаемой памяти по статьям; фигура, на которую ссылаются
+    // несколько элементов, учитывается один раз. Перемещённый массив памяти
+    // не занимает, и отчёт для него нулевой.
+    MemoryReport memoryReport() const {
+        MemoryReport report;
+        if (!chunks) return report;
+        size_t used = capacity / ChunkSize;
+        size_t chunkControl = sharedArrayControlBytes<T>(alloc);
+        size_t tableControl = sharedArrayControlBytes<Chunk>(TableAlloc(alloc));
+        report.elementBytes = size * sizeof(T);
+        report.slackBytes = (capacity - size) * sizeof(T) + (slots - used) * sizeof(Chunk);
+        report.tableBytes = used * sizeof(Chunk);
+        report.controlBlockBytes = used * chunkControl + tableControl;
+        report.allocatorOverheadBytes = used * mallocOverhead(ChunkSize * sizeof(T) + chunkControl)
+            + mallocOverhead(slots * sizeof(Chunk) + tableControl);
+
+        std::unordered_set<const void*> seen;
+        forEach([&](const T& e) {
+            if constexpr (requires { e.get(); figureOf(e).footprint(); }) {
+                if (e == nullptr || !seen.insert(e.get()).second) return;
+                Footprint f = figureOf(e).footprint();
+                report.figureHeapBytes += f.objectBytes + f.heapBytes;
+                report.controlBlockBytes += ControlBlockBytes;
+                report.allocatorOverheadBytes += mallocOverhead(f.objectBytes + ControlBlockBytes)
+                    + f.heapBlocks * mallocOverhead(f.heapBlocks ? f.heapBytes / f.heapBlocks : 0);
+            } else if constexpr (requires { e.footprint(); }) {
+                Footprint f = e.footprint();
+                report.figureHeapBytes += f.heapBytes;
+                report.allocatorOverheadBytes += f.heapBlocks * mallocOverhead(f.heapBlocks ? f.heapBytes / f.heapBlocks : 0);
+            }
+        });
+        // Свободные слоты чанка хранят фигуры по умолчанию, и их вершины тоже в куче.
+        if constexpr (!requires(const T& e) { e.get(); } && requires(const T& e) { e.footprint(); }) {
+            static const Footprint empty = T{}.footprint();
+            size_t free = capacity - size;
+            report.figureHeapBytes += free * empty.heapBytes;
+            report.allocatorOverheadBytes += free * empty.heapBlocks
+                * mallocOverhead(empty.heapBlocks ? empty.heapBytes / empty.heapBlocks : 0);
+        }
+        return report;
     }
 
     void printSurfaces() const {
         std::cout << std::fixed << std::setprecision(2);
         for (size_t i = 0; i < size; ++i) {
-            if constexpr (requires { double(data[i]); }) {
-                std::cout << i << ": " << *data[i]
-                    << " | Surface = " << double(data[i]) << std::endl;
-            } else if constexpr (requires { double(*data[i]); }) {
-                std::cout << i << ": " << *data[i]
-                    << " | Surface = " << double(*data[i]) << std::endl;
+            if constexpr (requires { double(cell(i)); }) {
+                std::cout << i << ": " << *cell(i)
+                    << " | Surface = " << double(cell(i)) << std::endl;
+            } else if constexpr (requires { double(*cell(i)); }) {
+                std::cout << i << ": " << *cell(i)
+                    << " | Surface = " << double(*cell(i)) << std::endl;
             }
         }
     }
 
     void printCenters() const {
         for (size_t i = 0; i < size; ++i) {
-            if constexpr (requires { data[i].center(); }) {
-                auto c = data[i].center();
+            if constexpr (requires { cell(i).center(); }) {
+                auto c = cell(i).center();
                 std::cout << i << ": Center = (" << c.x << ", " << c.y << ")\n";
-            } else if constexpr (requires { data[i]->center(); }) {
-                auto c = data[i]->center();
+            } else if constexpr (requires { cell(i)->center(); }) {
+                auto c = cell(i)->center();
                 std::cout << i << ": Center = (" << c.x << ", " << c.y << ")\n";
             }
         }
     }
 
     double totalSurface() const {
-        double sum = 0;
+        if (stats) return stats->totalSurface();
+        KahanSum sum;
         for (size_t i = 0; i < size; ++i) {
-            if constexpr (requires { double(data[i]); }) sum += double(data[i]);
-            else if constexpr (requires { double(*data[i]); }) sum += double(*data[i]);
+            if constexpr (requires { double(cell(i)); }) sum.add(double(cell(i)));
+            else if constexpr (requires { double(*cell(i)); }) {
+                if (present(cell(i))) sum.add(double(*cell(i)));
+            }
         }
-        return sum;
+        return sum.value();
     }
 
     void print() const {
-        for (size_t i = 0; i < size; ++i) std::cout << "[" << i << "] " << data[i] << "\n";
+        for (size_t i = 0; i < size; ++i) std::cout << "[" << i << "] " << cell(i) << "\n";
     }
 
     size_t getSize() const {
@@ -103,20 +294,160 @@ public:
     size_t getCapacity() const {
         return capacity;
     }
+
+    // Число изменений через add/remove/set; чтение через operator[] её не меняет.
+    size_t getVersion() const {
+        return version;
+    }
     
     ~Array() = default;
 
 private:
-    std::shared_ptr<T[]> data;
+    using Chunk = std::shared_ptr<T[]>;
+    using TableAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Chunk>;
+
+    std::shared_ptr<Chunk[]> chunks;
     size_t size;
     size_t capacity;
+    size_t slots;
+    size_t version{0};
+    std::shared_ptr<ArrayStats> stats;
+    std::vector<bool> leaked;  // чанки, на элементы которых выданы T&
+    Alloc alloc;
+
+    Chunk newChunk() const {
+        return std::allocate_shared<T[]>(alloc, ChunkSize);
+    }
+
+    std::shared_ptr<Chunk[]> newTable(size_t n) const {
+        return std::allocate_shared<Chunk[]>(TableAlloc(alloc), n);
+    }
+
+    const T& cell(size_t index) const {
+        return chunks[index / ChunkSize][index % ChunkSize];
+    }
+
+    // use_count() читается relaxed, поэтому после проверки на единственного
+    // владельца нужен acquire-барьер: чтения освободившего ссылку читателя
+    // должны завершиться до нашей записи.
+    template <class P>
+    static bool unique(const P& p) {
+        if (p.use_count() > 1) return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    static bool present(const T& e) {
+        if constexpr (requires { e == nullptr; }) return e != nullptr;
+        else return true;
+    }
+
+    // Агрегаты разделяются копиями и клонируются при записи: копия ArrayStats
+    // делит с оригиналом блоки вкладов, как таблица делит чанки.
+    ArrayStats* writableStats() {
+        if (!stats) return nullptr;
+        if (!unique(stats)) stats = std::make_shared<ArrayStats>(*stats);
+        return stats.get();
+    }
+
+    void trackAdded() {
+        if constexpr (FigureLike<T>) {
+            ArrayStats* st = writableStats();
+            if (!st) return;
+            if (present(cell(size - 1))) st->insert(figureOf(cell(size - 1)));
+            else st->insertEmpty();
+        }
+    }
+
+    void trackRemoved(size_t index) {
+        if constexpr (FigureLike<T>) {
+            if (ArrayStats* st = writableStats()) st->erase(index);
+        }
+    }
+
+    void trackReplaced(size_t index) {
+        if constexpr (FigureLike<T>) {
+            ArrayStats* st = writableStats();
+            if (!st) return;
+            if (present(cell(index))) st->replace(index, figureOf(cell(index)));
+            else st->replaceEmpty(index);
+        }
+    }
+
+    // Доступ без проверок; чанк уже должен принадлежать только этому массиву.
+    T& slot(size_t index) {
+        return chunks[index / ChunkSize][index % ChunkSize];
+    }
+
+    T* writableChunk(size_t c) {
+        if (!unique(chunks)) {
+            auto table = newTable(slots);
+            for (size_t i = 0; i < slots; ++i) table[i] = chunks[i];
+            chunks = std::move(table);
+        }
+        Chunk& chunk = chunks[c];
+        if (!unique(chunk)) chunk = cloneChunk(chunk);
+        return chunk.get();
+    }
+
+    Chunk cloneChunk(const Chunk& chunk) const {
+        auto copy = newChunk();
+        for (size_t i = 0; i < ChunkSize; ++i) copy[i] = chunk[i];
+        return copy;
+    }
+
+    // Запись самим массивом: ранее выданные ссылки после неё недействительны.
+    T& writable(size_t index) {
+        ++version;
+        leaked.clear();
+        return writableChunk(index / ChunkSize)[index % ChunkSize];
+    }
+
+    // Ссылка наружу: чанк становится собственным и помечается, чтобы копии
+    // и снимки получали его клон, пока ссылка может использоваться.
+    T& exposed(size_t index) {
+        size_t c = index / ChunkSize;
+        if (c >= leaked.size() || !leaked[c]) {
+            writableChunk(c);
+            if (leaked.size() <= c) leaked.resize(c + 1);
+            leaked[c] = true;
+        }
+        return slot(index);
+    }
 
     void resize() {
-        capacity *= 2;
-        auto newData = std::make_shared<T[]>(capacity);
-        for (size_t i = 0; i < size; ++i) newData[i] = std::move(data[i]);
-        data = std::move(newData);
+        size_t used = capacity / ChunkSize;
+        if (used == slots || !unique(chunks)) {
+            if (used == slots) slots = slots ? slots * 2 : 4;
+            auto table = newTable(slots);
+            for (size_t c = 0; c < used; ++c) table[c] = chunks[c];
+            chunks = std::move(table);
+        }
+        chunks[used] = newChunk();
+        capacity += ChunkSize;
     }
 };
 
+template <class T, class Alloc>
+class ArraySnapshot {
+public:
+    const T& operator[](size_t index) const { return items[index]; }
+
+    void printSurfaces() const { items.printSurfaces(); }
+    void printCenters() const { items.printCenters(); }
+    double totalSurface() const { return items.totalSurface(); }
+    bool hasStats() const { return items.hasStats(); }
+    const ArrayStats& getStats() const { return items.getStats(); }
+
+    size_t getSize() const { return items.getSize(); }
+    size_t getVersion() const { return items.getVersion(); }
+
+private:
+    friend class Array<T, Alloc>;
+
+    explicit ArraySnapshot(const Array<T, Alloc>& source) : items(source) {}
+
+    const Array<T, Alloc> items;
+};
+
 #endif
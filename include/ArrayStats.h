@@ -0,0 +1,210 @@
+#ifndef ARRAY_STATS_H
+#define ARRAY_STATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
+
+#include "Point.h"
+#include "KahanSum.h"
+
+// Доступ к фигуре как для значения, так и для указателя на неё.
+template <class E>
+const auto& figureOf(const E& e) {
+    if constexpr (requires { e->surface(); }) return *e;
+    else return e;
+}
+
+template <class E>
+concept FigureLike = requires (const E& e) {
+    figureOf(e).surface();
+    figureOf(e).center();
+};
+
+// Агрегаты, которые Array обновляет на add/remove/set вместо полного обхода.
+// Вклад каждого элемента запоминается по его индексу, и при удалении
+// вычитается именно он: фигура могла измениться на месте после добавления.
+// Вклады лежат блоками по BlockSize, как элементы в чанках Array, и так же
+// разделяются копиями: копия ArrayStats стоит O(n / BlockSize), а запись
+// дублирует только свой блок. Суммы и счётчики типов копируются по значению,
+// минимум и максимум хранятся по блокам и собираются при чтении.
+class ArrayStats {
+public:
+    static constexpr size_t BlockSize = 64;
+
+    template <class F>
+    void insert(const F& fig) {
+        Entry e = entryOf(fig);
+        apply(e);
+        append(e);
+    }
+
+    // Пустой элемент (nullptr) занимает индекс, но в агрегаты не входит.
+    void insertEmpty() {
+        append(Entry{});
+    }
+
+    void erase(size_t index) {
+        if (index >= size) throw std::out_of_range("ArrayStats: index out of range");
+        revert(entry(index));
+        for (size_t b = index / BlockSize; b * BlockSize < size; ++b) writableBlock(b);
+        for (size_t i = index; i + 1 < size; ++i) slot(i) = slot(i + 1);
+        slot(size - 1) = Entry{};
+        --size;
+        for (size_t b = index / BlockSize; b * BlockSize < size; ++b) refresh(b);
+        if (size % BlockSize == 0) blocks.pop_back();
+    }
+
+    template <class F>
+    void replace(size_t index, const F& fig) {
+        Entry e = entryOf(fig);
+        assign(index, e);
+    }
+
+    void replaceEmpty(size_t index) {
+        assign(index, Entry{});
+    }
+
+    size_t count() const {
+        return present;
+    }
+
+    size_t countOf(std::type_index type) const {
+        auto it = types.find(type);
+        return it == types.end() ? 0 : it->second;
+    }
+
+    template <class F>
+    size_t countOf() const {
+        return countOf(std::type_index(typeid(F)));
+    }
+
+    double totalSurface() const {
+        return total.value();
+    }
+
+    double minSurface() const {
+        double best = std::numeric_limits<double>::infinity();
+        for (const auto& block : blocks)
+            if (block->present) best = std::min(best, block->minSurface);
+        return present ? best : 0.0;
+    }
+
+    double maxSurface() const {
+        double best = -std::numeric_limits<double>::infinity();
+        for (const auto& block : blocks)
+            if (block->present) best = std::max(best, block->maxSurface);
+        return present ? best : 0.0;
+    }
+
+    Point<double> centroid() const {
+        if (present == 0) return Point<double>{};
+        double n = static_cast<double>(present);
+        return Point<double>{centerX.value() / n, centerY.value() / n};
+    }
+
+private:
+    struct Entry {
+        double surface{0.0};
+        double centerX{0.0};
+        double centerY{0.0};
+        const std::type_info* type{nullptr};  // nullptr — пустой элемент
+    };
+
+    struct Block {
+        Entry entries[BlockSize];
+        double minSurface{0.0};  // по непустым элементам блока
+        double maxSurface{0.0};
+        size_t present{0};
+    };
+
+    std::vector<std::shared_ptr<Block>> blocks;
+    size_t size{0};
+    size_t present{0};
+    KahanSum total;
+    KahanSum centerX;
+    KahanSum centerY;
+    std::map<std::type_index, size_t> types;
+
+    template <class F>
+    static Entry entryOf(const F& fig) {
+        auto c = fig.center();
+        return Entry{fig.surface(), double(c.x), double(c.y), &typeid(fig)};
+    }
+
+    const Entry& entry(size_t index) const {
+        return blocks[index / BlockSize]->entries[index % BlockSize];
+    }
+
+    // Блок уже должен принадлежать только этому экземпляру.
+    Entry& slot(size_t index) {
+        return blocks[index / BlockSize]->entries[index % BlockSize];
+    }
+
+    // Как и в Array: после relaxed-чтения use_count() нужен acquire-барьер.
+    Block& writableBlock(size_t b) {
+        std::shared_ptr<Block>& block = blocks[b];
+        if (block.use_count() > 1) block = std::make_shared<Block>(*block);
+        else std::atomic_thread_fence(std::memory_order_acquire);
+        return *block;
+    }
+
+    void append(const Entry& e) {
+        if (size % BlockSize == 0) blocks.push_back(std::make_shared<Block>());
+        Block& block = writableBlock(size / BlockSize);
+        block.entries[size % BlockSize] = e;
+        ++size;
+        include(block, e);
+    }
+
+    void assign(size_t index, const Entry& e) {
+        if (index >= size) throw std::out_of_range("ArrayStats: index out of range");
+        revert(entry(index));
+        apply(e);
+        writableBlock(index / BlockSize);
+        slot(index) = e;
+        refresh(index / BlockSize);
+    }
+
+    static void include(Block& block, const Entry& e) {
+        if (!e.type) return;
+        if (block.present == 0 || e.surface < block.minSurface) block.minSurface = e.surface;
+        if (block.present == 0 || e.surface > block.maxSurface) block.maxSurface = e.surface;
+        ++block.present;
+    }
+
+    void refresh(size_t b) {
+        Block& block = *blocks[b];
+        size_t used = std::min(BlockSize, size - b * BlockSize);
+        block.present = 0;
+        for (size_t i = 0; i < used; ++i) include(block, block.entries[i]);
+    }
+
+    void apply(const Entry& e) {
+        if (!e.type) return;
+        total.add(e.surface);
+        centerX.add(e.centerX);
+        centerY.add(e.centerY);
+        ++types[std::type_index(*e.type)];
+        ++present;
+    }
+
+    void revert(const Entry& e) {
+        if (!e.type) return;
+        auto type = types.find(std::type_index(*e.type));
+        if (type == types.end()) throw std::logic_error("ArrayStats: type of a tracked element is missing");
+        if (--type->second == 0) types.erase(type);
+        total.sub(e.surface);
+        centerX.sub(e.centerX);
+        centerY.sub(e.centerY);
+        --present;
+    }
+};
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef BATCH_DRIVER_H
+#define BATCH_DRIVER_H
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "Array.h"
+#include "Square.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+
+// Неинтерактивный прогон сценария над Array<shared_ptr<Figure<double>>>.
+// Сценарий — по команде в строке, '#' начинает комментарий:
+//   seed S          — зерно генератора
+//   generate N      — сгенерировать по N фигур каждого типа
+//   load FILE       — прочитать фигуры из файла: "square|rectangle|trapezoid x0 y0 ... x3 y3"
+//   add             — добавить сгенерированные/загруженные фигуры в массив
+//   remove K        — удалить K элементов со случайных позиций
+//   total [R]       — R раз посчитать totalSurface
+//   centers [R]     — R раз пройти по центрам всех фигур
+//   equality [R]    — R раз сравнить соседние фигуры operator==
+//   copy            — скопировать и переместить каждую фигуру
+//   stats           — включить инкрементальные агрегаты
+//   memory          — оценка памяти массива (result — всего байт, см. Array::memoryReport)
+//   clear           — очистить массив
+// На каждую команду печатается одна строка JSON с временем, пропускной
+// способностью и пиковым RSS процесса.
+class BatchDriver {
+public:
+    explicit BatchDriver(std::ostream& out) : out(out), rng(1) {}
+
+    void runScript(std::istream& script) {
+        std::string line;
+        while (std::getline(script, line)) {
+            auto hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            run(line);
+        }
+    }
+
+    void run(const std::string& command) {
+        std::istringstream iss(command);
+        std::string op;
+        iss >> op;
+
+        auto start = std::chrono::steady_clock::now();
+        size_t items = 0;
+        double result = 0;
+
+        if (op == "seed") {
+            unsigned seed = 1;
+            iss >> seed;
+            rng.seed(seed);
+        } else if (op == "generate") {
+            size_t n = 0;
+            iss >> n;
+            items = generate(n);
+        } else if (op == "load") {
+            std::string path;
+            iss >> path;
+            items = load(path);
+        } else if (op == "add") {
+            for (auto& fig : pending) figures.add(std::move(fig));
+            items = pending.size();
+            pending.clear();
+        } else if (op == "remove") {
+            size_t k = 0;
+            iss >> k;
+            for (; items < k && figures.getSize() > 0; ++items)
+                figures.remove(rng() % figures.getSize());
+        } else if (op == "total") {
+            size_t repeat = readRepeat(iss);
+            for (size_t r = 0; r < repeat; ++r) result += figures.totalSurface();
+            items = repeat * figures.getSize();
+        } else if (op == "centers") {
+            size_t repeat = readRepeat(iss);
+            const auto& view = figures;
+            for (size_t r = 0; r < repeat; ++r)
+                for (size_t i = 0; i < view.getSize(); ++i) {
+                    auto c = view[i]->center();
+                    result += c.x + c.y;
+                }
+            items = repeat * figures.getSize();
+        } else if (op == "equality") {
+            size_t repeat = readRepeat(iss);
+            const auto& view = figures;
+            for (size_t r = 0; r < repeat; ++r)
+                for (size_t i = 1; i < view.getSize(); ++i) result += (*view[i - 1] == *view[i]);
+            items = repeat * (figures.getSize() ? figures.getSize() - 1 : 0);
+        } else if (op == "copy") {
+            items = copyAndMove(result);
+        } else if (op == "memory") {
+            result = double(figures.memoryReport().total());
+            items = figures.getSize();
+        } else if (op == "stats") {
+            figures.trackStats();
+            items = figures.getSize();
+        } else if (op == "clear") {
+            items = figures.getSize();
+            figures = Array<std::shared_ptr<Figure<double>>>();
+        } else {
+            throw std::invalid_argument("Unknown batch command: " + op);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        out << "{\"phase\":\"" << op << "\",\"items\":" << items
+            << ",\"seconds\":" << std::setprecision(9) << std::defaultfloat << seconds
+            << ",\"items_per_sec\":" << (seconds > 0 ? items / seconds : 0.0)
+            << ",\"size\":" << figures.getSize()
+            << ",\"result\":" << result
+            << ",\"peak_rss_kb\":" << peakRssKb() << "}" << std::endl;
+    }
+
+    const Array<std::shared_ptr<Figure<double>>>& getFigures() const {
+        return figures;
+    }
+
+    // Разбор аргументов командной строки. Возвращает false, если batch-режим
+    // не запрошен и нужно запустить интерактивную демонстрацию.
+    static bool runFromArgs(int argc, char** argv, std::ostream& out) {
+        std::string script, ops = "add,total,centers,equality,copy,remove";
+        size_t count = 1000, repeat = 1;
+        unsigned seed = 1;
+        bool batch = false;
+
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--batch") batch = true;
+            else if (arg == "--script") { script = value(); batch = true; }
+            else if (arg == "--count") { count = std::stoul(value()); batch = true; }
+            else if (arg == "--repeat") { repeat = std::stoul(value()); batch = true; }
+            else if (arg == "--seed") { seed = std::stoul(value()); batch = true; }
+            else if (arg == "--ops") { ops = value(); batch = true; }
+            else throw std::invalid_argument("Unknown argument: " + arg);
+        }
+        if (!batch) return false;
+
+        BatchDriver driver(out);
+        if (!script.empty()) {
+            if (script == "-") {
+                driver.runScript(std::cin);
+            } else {
+                std::ifstream file(script);
+                if (!file) throw std::runtime_error("Cannot open script: " + script);
+                driver.runScript(file);
+            }
+            return true;
+        }
+
+        std::ostringstream generated;
+        generated << "seed " << seed << "\ngenerate " << count << "\n";
+        std::istringstream list(ops);
+        for (std::string op; std::getline(list, op, ',');) {
+            if (op == "add" || op == "copy" || op == "stats" || op == "clear" || op == "memory") generated << op << "\n";
+            else if (op == "remove") generated << "remove " << count << "\n";
+            else generated << op << " " << repeat << "\n";
+        }
+        std::istringstream commands(generated.str());
+        driver.runScript(commands);
+        return true;
+    }
+
+private:
+    std::ostream& out;
+    std::mt19937 rng;
+    Array<std::shared_ptr<Figure<double>>> figures;
+    std::vector<std::shared_ptr<Figure<double>>> pending;
+
+    static size_t readRepeat(std::istream& is) {
+        size_t repeat = 1;
+        is >> repeat;
+        return repeat;
+    }
+
+    static long peakRssKb() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    size_t generate(size_t n) {
+        std::uniform_real_distribution<double> coord(-1000.0, 1000.0);
+        std::uniform_real_distribution<double> side(0.5, 50.0);
+        for (size_t i = 0; i < n; ++i) {
+            // Шаг 1/4 точно представим, поэтому все фигуры проходят validate().
+            auto grid = [](double v) { return std::round(v * 4) / 4; };
+            double x = grid(coord(rng)), y = grid(coord(rng)), a = grid(side(rng)), b = grid(side(rng));
+            std::ostringstream sq, rect, trap;
+            sq << x << " " << y << " " << x + a << " " << y << " " << x + a << " " << y + a << " " << x << " " << y + a;
+            rect << x << " " << y << " " << x + a << " " << y << " " << x + a << " " << y + b << " " << x << " " << y + b;
+            trap << x << " " << y << " " << x + 3 * a << " " << y << " " << x + 2 * a << " " << y + b
+                 << " " << x + a << " " << y + b;
+            pending.push_back(parse("square", sq.str()));
+            pending.push_back(parse("rectangle", rect.str()));
+            pending.push_back(parse("trapezoid", trap.str()));
+        }
+        return 3 * n;
+    }
+
+    size_t load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) throw std::runtime_error("Cannot open figures file: " + path);
+        size_t loaded = 0;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream iss(line);
+            std::string type, rest;
+            if (!(iss >> type)) continue;
+            std::getline(iss, rest);
+            try {
+                pending.push_back(parse(type, rest));
+                ++loaded;
+            } catch (const std::invalid_argument&) {
+            }
+        }
+        return loaded;
+    }
+
+    static std::shared_ptr<Figure<double>> parse(const std::string& type, const std::string& coords) {
+        std::shared_ptr<Figure<double>> fig;
+        if (type == "square") fig = std::make_shared<Square<double>>();
+        else if (type == "rectangle") fig = std::make_shared<Rectangle<double>>();
+        else if (type == "trapezoid") fig = std::make_shared<Trapezoid<double>>();
+        else throw std::invalid_argument("Unknown figure type: " + type);
+        std::istringstream iss(coords);
+        iss >> *fig;
+        return fig;
+    }
+
+    template <class F>
+    static bool copyAndMoveAs(const Figure<double>& fig, double& result) {
+        const auto* typed = dynamic_cast<const F*>(&fig);
+        if (!typed) return false;
+        F copy = *typed;
+        F moved = std::move(copy);
+        result += moved.surface();
+        return true;
+    }
+
+    size_t copyAndMove(double& result) {
+        const auto& view = figures;
+        for (size_t i = 0; i < view.getSize(); ++i) {
+            const Figure<double>& fig = *view[i];
+            copyAndMoveAs<Square<double>>(fig, result) || copyAndMoveAs<Rectangle<double>>(fig, result)
+                || copyAndMoveAs<Trapezoid<double>>(fig, result);
+        }
+        return figures.getSize();
+    }
+};
+
+#endif
@@ -0,0 +1,393 @@
+#ifndef CENTER_CLUSTERING_H
+#define CENTER_CLUSTERING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Array.h"
+#include "KahanSum.h"
+#include "Point.h"
+
+// Центры и площади фигур, один раз выгруженные из Array в непрерывные массивы
+// (структура массивов), чтобы кластеризация не делала виртуальных вызовов.
+// index — позиция фигуры в исходном Array: пустые элементы пропускаются.
+struct CenterBuffer {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> surface;
+    std::vector<size_t> index;
+
+    size_t size() const {
+        return x.size();
+    }
+
+    void add(double cx, double cy, double s, size_t sourceIndex) {
+        x.push_back(cx);
+        y.push_back(cy);
+        surface.push_back(s);
+        index.push_back(sourceIndex);
+    }
+
+    // Точка без исходного Array: её индекс — позиция в самом буфере.
+    void add(double cx, double cy, double s) {
+        add(cx, cy, s, size());
+    }
+
+    void reserve(size_t n) {
+        x.reserve(n);
+        y.reserve(n);
+        surface.reserve(n);
+        index.reserve(n);
+    }
+
+    template <class E, class A>
+    static CenterBuffer from(const Array<E, A>& figures) {
+        CenterBuffer buffer;
+        buffer.reserve(figures.getSize());
+        size_t i = 0;
+        figures.forEach([&](const E& e) {
+            size_t position = i++;
+            if constexpr (requires { e == nullptr; }) {
+                if (e == nullptr) return;
+            }
+            const auto& fig = figureOf(e);
+            auto c = fig.center();
+            buffer.add(c.x, c.y, fig.surface(), position);
+        });
+        return buffer;
+    }
+};
+
+struct ClusteringResult {
+    static constexpr uint32_t Noise = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint32_t> assignment;     // кластер каждой точки буфера (Noise — вне кластеров)
+    std::vector<Point<double>> centroids;
+    std::vector<size_t> sizes;
+    std::vector<double> surface;          // суммарная площадь фигур кластера
+    size_t iterations{0};
+    double inertia{0.0};                  // сумма квадратов расстояний до центроидов
+    bool converged{false};
+};
+
+namespace detail {
+
+// Статическое разбиение [0, n) на непрерывные блоки по потокам.
+template <class F>
+void parallelBlocks(size_t n, unsigned threads, F&& body) {
+    threads = unsigned(std::max<size_t>(1, std::min<size_t>(threads, n / 4096 + 1)));
+    std::vector<std::thread> pool;
+    size_t step = (n + threads - 1) / threads;
+    for (unsigned t = 1; t < threads; ++t) {
+        size_t begin = std::min(n, t * step), end = std::min(n, begin + step);
+        pool.emplace_back([&body, t, begin, end] { body(t, begin, end); });
+    }
+    body(0u, size_t(0), std::min(n, step));
+    for (auto& t : pool) t.join();
+}
+
+inline unsigned defaultThreads(unsigned threads) {
+    return threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+}  // namespace detail
+
+// Алгоритм Ллойда с инициализацией k-means++. Точки делятся между потоками
+// блоками, каждый поток копит свои суммы по кластерам, затем они сводятся.
+class KMeans {
+public:
+    explicit KMeans(size_t k, unsigned threads = 0, size_t maxIterations = 100,
+                    double tolerance = 1e-12, unsigned seed = 1)
+        : k(k), threads(detail::defaultThreads(threads)), maxIterations(maxIterations),
+          tolerance(tolerance), seed(seed) {
+        if (k == 0) throw std::invalid_argument("k must be positive");
+    }
+
+    ClusteringResult run(const CenterBuffer& points) const {
+        if (points.size() < k) throw std::invalid_argument("Fewer points than clusters");
+        size_t n = points.size();
+        std::vector<double> cx(k), cy(k);
+        initialize(points, cx, cy);
+
+        ClusteringResult result;
+        result.assignment.assign(n, 0);
+        std::vector<Partial> partials(threads, Partial(k));
+
+        for (result.iterations = 1; result.iterations <= maxIterations; ++result.iterations) {
+            assign(points, cx, cy, result.assignment, partials);
+            Partial total = reduce(partials);
+
+            double shift = 0;
+            for (size_t c = 0; c < k; ++c) {
+                if (total.count[c] == 0) continue;  // пустой кластер сохраняет прежний центр
+                double nx = total.sumX[c] / total.count[c], ny = total.sumY[c] / total.count[c];
+                shift = std::max(shift, (nx - cx[c]) * (nx - cx[c]) + (ny - cy[c]) * (ny - cy[c]));
+                cx[c] = nx;
+                cy[c] = ny;
+            }
+            if (shift <= tolerance) {
+                result.converged = true;
+                break;
+            }
+        }
+        result.iterations = std::min(result.iterations, maxIterations);
+
+        // Финальное назначение под итоговые центры: размеры, площади, инерция.
+        assign(points, cx, cy, result.assignment, partials);
+        Partial total = reduce(partials);
+        for (size_t c = 0; c < k; ++c) {
+            result.centroids.emplace_back(cx[c], cy[c]);
+            result.sizes.push_back(total.count[c]);
+            result.surface.push_back(total.surface[c]);
+        }
+        result.inertia = total.inertia;
+        return result;
+    }
+
+private:
+    struct Partial {
+        explicit Partial(size_t k) : sumX(k), sumY(k), surface(k), count(k) {}
+        std::vector<double> sumX, sumY, surface;
+        std::vector<size_t> count;
+        double inertia{0.0};
+    };
+
+    size_t k;
+    unsigned threads;
+    size_t maxIterations;
+    double tolerance;
+    unsigned seed;
+
+    // k-means++: каждый следующий центр выбирается с вероятностью,
+    // пропорциональной квадрату расстояния до ближайшего уже выбранного.
+    void initialize(const CenterBuffer& points, std::vector<double>& cx, std::vector<double>& cy) const {
+        size_t n = points.size();
+        std::mt19937_64 rng(seed);
+        size_t first = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+        cx[0] = points.x[first];
+        cy[0] = points.y[first];
+
+        std::vector<double> nearest(n);
+        std::vector<double> blockSum(threads);
+        for (size_t c = 0; c < k; ++c) {
+            double px = cx[c], py = cy[c];
+            detail::parallelBlocks(n, threads, [&](unsigned t, size_t begin, size_t end) {
+                double sum = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    double dx = points.x[i] - px, dy = points.y[i] - py;
+                    double d = dx * dx + dy * dy;
+                    nearest[i] = c == 0 ? d : std::min(nearest[i], d);
+                    sum += nearest[i];
+                }
+                blockSum[t] = sum;
+            });
+            if (c + 1 == k) break;
+
+            double total = 0;
+            for (unsigned t = 0; t < threads; ++t) total += blockSum[t];
+            std::fill(blockSum.begin(), blockSum.end(), 0.0);
+            size_t pick = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+            if (total > 0) {
+                double target = std::uniform_real_distribution<double>(0, total)(rng);
+                for (pick = 0; pick + 1 < n && (target -= nearest[pick]) > 0; ++pick) {}
+            }
+            cx[c + 1] = points.x[pick];
+            cy[c + 1] = points.y[pick];
+        }
+    }
+
+    // Ближайший центр ищется сразу для блока точек: центры во внешнем цикле,
+    // точки блока во внутреннем. Расстояния и выбор номера идут одним циклом,
+    // обновление минимума — вторым: GCC не превращает в векторный код цикл с
+    // двумя условными присваиваниями сразу. Блок фиксированного размера лежит
+    // на стеке, хвост дополняется копией первой точки, поэтому число итераций
+    // известно и цикл векторизуется уже на -O2. Суммы по кластерам копятся
+    // отдельным проходом. При равных расстояниях побеждает меньший номер центра.
+    static constexpr size_t AssignBlock = 256;
+
+    struct AssignScratch {
+        double x[AssignBlock], y[AssignBlock];
+        double best[AssignBlock], distance[AssignBlock];
+        uint64_t bestIndex[AssignBlock];
+    };
+
+    void assign(const CenterBuffer& points, const std::vector<double>& cx, const std::vector<double>& cy,
+                std::vector<uint32_t>& assignment, std::vector<Partial>& partials) const {
+        for (auto& p : partials) p = Partial(k);
+        const double* ccx = cx.data();
+        const double* ccy = cy.data();
+        detail::parallelBlocks(points.size(), threads, [&](unsigned t, size_t begin, size_t end) {
+            Partial& part = partials[t];
+            AssignScratch block;
+            for (size_t start = begin; start < end; start += AssignBlock) {
+                size_t m = std::min(AssignBlock, end - start);
+                std::copy_n(points.x.data() + start, m, block.x);
+                std::copy_n(points.y.data() + start, m, block.y);
+                std::fill(block.x + m, block.x + AssignBlock, block.x[0]);
+                std::fill(block.y + m, block.y + AssignBlock, block.y[0]);
+                std::fill_n(block.best, AssignBlock, std::numeric_limits<double>::infinity());
+                std::fill_n(block.bestIndex, AssignBlock, uint64_t(0));
+                for (size_t c = 0; c < k; ++c) {
+                    double qx = ccx[c], qy = ccy[c];
+                    for (size_t j = 0; j < AssignBlock; ++j) {
+                        double dx = block.x[j] - qx, dy = block.y[j] - qy;
+                        double d = dx * dx + dy * dy;
+                        block.distance[j] = d;
+                        block.bestIndex[j] = d < block.best[j] ? uint64_t(c) : block.bestIndex[j];
+                    }
+                    for (size_t j = 0; j < AssignBlock; ++j)
+                        block.best[j] = block.distance[j] < block.best[j] ? block.distance[j] : block.best[j];
+                }
+                for (size_t j = 0; j < m; ++j) {
+                    uint32_t c = uint32_t(block.bestIndex[j]);
+                    assignment[start + j] = c;
+                    part.sumX[c] += block.x[j];
+                    part.sumY[c] += block.y[j];
+                    part.surface[c] += points.surface[start + j];
+                    ++part.count[c];
+                    part.inertia += block.best[j];
+                }
+            }
+        });
+    }
+
+    Partial reduce(const std::vector<Partial>& partials) const {
+        Partial total(k);
+        for (const auto& p : partials) {
+            for (size_t c = 0; c < k; ++c) {
+                total.sumX[c] += p.sumX[c];
+                total.sumY[c] += p.sumY[c];
+                total.surface[c] += p.surface[c];
+                total.count[c] += p.count[c];
+            }
+            total.inertia += p.inertia;
+        }
+        return total;
+    }
+};
+
+// Плотностная кластеризация по сетке: точки раскладываются по ячейкам cellSize,
+// ячейки с не менее чем minPoints точками считаются плотными, и связные
+// (по 8 соседям) плотные ячейки образуют кластер. Точки разреженных ячеек — Noise.
+// Номер ячейки по каждой оси должен помещаться в int32_t: NaN, бесконечность
+// или слишком малый для таких координат cellSize дают std::invalid_argument.
+class GridClustering {
+public:
+    explicit GridClustering(double cellSize, size_t minPoints = 1, unsigned threads = 0)
+        : cellSize(cellSize), minPoints(minPoints), threads(detail::defaultThreads(threads)) {
+        if (cellSize <= 0) throw std::invalid_argument("Cell size must be positive");
+    }
+
+    ClusteringResult run(const CenterBuffer& points) const {
+        size_t n = points.size();
+        std::vector<uint64_t> keys(n);
+        std::atomic<bool> outside{false};
+        detail::parallelBlocks(n, threads, [&](unsigned, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                int32_t gx, gy;
+                if (cellOf(points.x[i], gx) && cellOf(points.y[i], gy)) keys[i] = key(gx, gy);
+                else outside.store(true, std::memory_order_relaxed);
+            }
+        });
+        if (outside) throw std::invalid_argument("Point coordinates do not fit the clustering grid");
+
+        std::unordered_map<uint64_t, uint32_t> cellIndex;
+        std::vector<size_t> cellCount;
+        std::vector<uint64_t> cellKey;
+        std::vector<uint32_t> pointCell(n);
+        for (size_t i = 0; i < n; ++i) {
+            auto [it, inserted] = cellIndex.try_emplace(keys[i], uint32_t(cellCount.size()));
+            if (inserted) {
+                cellCount.push_back(0);
+                cellKey.push_back(keys[i]);
+            }
+            ++cellCount[it->second];
+            pointCell[i] = it->second;
+        }
+
+        std::vector<uint32_t> cellCluster(cellCount.size(), ClusteringResult::Noise);
+        uint32_t clusters = 0;
+        std::vector<uint64_t> stack;
+        // Кластеры нумеруются в порядке первой встречи ячейки, поэтому результат детерминирован.
+        for (uint32_t index = 0; index < cellCount.size(); ++index) {
+            if (cellCount[index] < minPoints || cellCluster[index] != ClusteringResult::Noise) continue;
+            cellCluster[index] = clusters;
+            stack.assign(1, cellKey[index]);
+            while (!stack.empty()) {
+                uint64_t cell = stack.back();
+                stack.pop_back();
+                int32_t gx = int32_t(cell >> 32), gy = int32_t(uint32_t(cell));
+                for (int dx = -1; dx <= 1; ++dx)
+                    for (int dy = -1; dy <= 1; ++dy) {
+                        auto it = cellIndex.find(key(gx + dx, gy + dy));
+                        if (it == cellIndex.end()) continue;
+                        uint32_t other = it->second;
+                        if (cellCount[other] < minPoints || cellCluster[other] != ClusteringResult::Noise) continue;
+                        cellCluster[other] = clusters;
+                        stack.push_back(it->first);
+                    }
+            }
+            ++clusters;
+        }
+
+        ClusteringResult result;
+        result.assignment.resize(n);
+        detail::parallelBlocks(n, threads, [&](unsigned, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) result.assignment[i] = cellCluster[pointCell[i]];
+        });
+
+        std::vector<KahanSum> sumX(clusters), sumY(clusters), surface(clusters);
+        result.sizes.assign(clusters, 0);
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t c = result.assignment[i];
+            if (c == ClusteringResult::Noise) continue;
+            sumX[c].add(points.x[i]);
+            sumY[c].add(points.y[i]);
+            surface[c].add(points.surface[i]);
+            ++result.sizes[c];
+        }
+        for (uint32_t c = 0; c < clusters; ++c) {
+            double m = double(result.sizes[c]);
+            result.centroids.emplace_back(sumX[c].value() / m, sumY[c].value() / m);
+            result.surface.push_back(surface[c].value());
+        }
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t c = result.assignment[i];
+            if (c == ClusteringResult::Noise) continue;
+            double dx = points.x[i] - result.centroids[c].x, dy = points.y[i] - result.centroids[c].y;
+            result.inertia += dx * dx + dy * dy;
+        }
+        result.iterations = 1;
+        result.converged = true;
+        return result;
+    }
+
+private:
+    double cellSize;
+    size_t minPoints;
+    unsigned threads;
+
+    // Координаты ячейки упаковываются в 32 бита на ось. Запас в единицу
+    // оставлен, чтобы соседи крайней ячейки тоже помещались в int32_t.
+    bool cellOf(double v, int32_t& cell) const {
+        constexpr double Limit = double(std::numeric_limits<int32_t>::max() - 1);
+        double g = std::floor(v / cellSize);
+        if (!(std::abs(g) <= Limit)) return false;
+        cell = int32_t(g);
+        return true;
+    }
+
+    static uint64_t key(int32_t gx, int32_t gy) {
+        return (uint64_t(uint32_t(gx)) << 32) | uint32_t(gy);
+    }
+};
+
+#endif
@@ -1,12 +1,42 @@
 #ifndef FIGURE_H
 #define FIGURE_H
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <string.h>
 #include <string_view>
 
 #include "Point.h"
 
+// Причина, по которой фигура не принята (для API без исключений).
+enum class FigureError {
+    None,
+    InputFailed,
+    DuplicateVertices,
+    InvalidShape,
+    Empty
+};
+
+inline const char* describe(FigureError error) {
+    switch (error) {
+        case FigureError::None: return "ok";
+        case FigureError::InputFailed: return "could not read vertex coordinates";
+        case FigureError::DuplicateVertices: return "vertices must be distinct";
+        case FigureError::InvalidShape: return "points do not form the figure";
+        case FigureError::Empty: return "no figure";
+    }
+    return "unknown error";
+}
+
+// Память, занимаемая фигурой: сам объект и отдельно выделенные в куче блоки.
+struct Footprint {
+    size_t objectBytes;
+    size_t heapBytes;
+    size_t heapBlocks;
+};
+
 template <IsScalar T>
 class Figure {
 protected:
@@ -14,18 +44,65 @@ protected:
 
     virtual void print(std::ostream& os) const = 0;
     virtual void read(std::istream& is) = 0;
+    virtual void readVertices(std::istream& is) = 0;
     virtual bool validate() const = 0;
 
+    // Допуск проверок формы: 1e-6 плюс погрешность округления координат типа T,
+    // растущая с их модулем и с длиной сравниваемых векторов. Для double это
+    // прежние 1e-6, для float при координатах порядка 100 — около 1e-4.
+    double tolerance(double length = 1.0) const {
+        double scale = 0.0;
+        for (size_t i = 0; i < vertexCount(); ++i) {
+            Point<T> v = vertex(i);
+            scale = std::max({scale, std::abs(double(v.x)), std::abs(double(v.y))});
+        }
+        return 1e-6 + 16 * double(std::numeric_limits<T>::epsilon()) * scale * std::max(1.0, length);
+    }
+
 public:
     virtual ~Figure() = default;
 
     virtual Point<T> center() const = 0;
     virtual double surface() const = 0;
+    virtual size_t vertexCount() const = 0;
+    virtual Point<T> vertex(size_t i) const = 0;
+    virtual Footprint footprint() const = 0;
+
+    // Проверка по правилу чётности пересечений, работает для любого
+    // простого многоугольника, заданного вершинами по порядку обхода.
+    bool contains(const Point<double>& p) const {
+        bool inside = false;
+        size_t n = vertexCount();
+        for (size_t i = 0, j = n - 1; i < n; j = i++) {
+            Point<T> a = vertex(i), b = vertex(j);
+            if ((a.y > p.y) != (b.y > p.y)) {
+                double x = a.x + (p.y - a.y) * (double(b.x) - a.x) / (double(b.y) - a.y);
+                if (p.x < x) inside = !inside;
+            }
+        }
+        return inside;
+    }
 
     virtual operator double() const = 0;
     virtual bool operator==(const Figure<T>& other) const = 0;
     virtual bool operator!=(const Figure<T>& other) const = 0;
 
+    // Ввод без приглашений и исключений: при ошибке возвращает её причину,
+    // а фигура остаётся с прочитанными (невалидными) вершинами, как и после read().
+    FigureError tryRead(std::istream& is) {
+        readVertices(is);
+        if (!is) return FigureError::InputFailed;
+        return check();
+    }
+
+    FigureError check() const {
+        size_t n = vertexCount();
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = i + 1; j < n; ++j)
+                if (vertex(i) == vertex(j)) return FigureError::DuplicateVertices;
+        return validate() ? FigureError::None : FigureError::InvalidShape;
+    }
+
     friend std::istream& operator>>(std::istream& is, Figure<T>& fig) {
         fig.read(is);
         return is;
@@ -0,0 +1,33 @@
+#ifndef KAHAN_SUM_H
+#define KAHAN_SUM_H
+
+#include <cmath>
+
+// Компенсированное суммирование (вариант Ноймайера): хранит потерянные
+// младшие разряды отдельно, поэтому длинные последовательности add/sub
+// не накапливают ошибку округления.
+class KahanSum {
+public:
+    KahanSum() = default;
+
+    void add(double x) {
+        double t = sum + x;
+        if (std::abs(sum) >= std::abs(x)) compensation += (sum - t) + x;
+        else compensation += (x - t) + sum;
+        sum = t;
+    }
+
+    void sub(double x) {
+        add(-x);
+    }
+
+    double value() const {
+        return sum + compensation;
+    }
+
+private:
+    double sum{0.0};
+    double compensation{0.0};
+};
+
+#endif
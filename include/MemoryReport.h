@@ -0,0 +1,127 @@
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Разбивка памяти кучи, которой владеет Array, по статьям (в байтах); сам
+// объект Array сюда не входит. Чанки и фигуры, разделяемые со снимками или
+// копиями, учитываются целиком.
+struct MemoryReport {
+    size_t elementBytes{0};            // занятые слоты чанков: size * sizeof(T)
+    size_t slackBytes{0};              // свободные слоты чанков и таблицы
+    size_t tableBytes{0};              // занятая часть таблицы чанков
+    size_t controlBlockBytes{0};       // блоки shared_ptr: для чанков и таблицы измерены, для фигур — оценка
+    size_t figureHeapBytes{0};         // фигуры за указателями и вершины фигур, включая фигуры в свободных слотах
+    size_t allocatorOverheadBytes{0};  // оценка заголовков и выравнивания malloc
+
+    size_t total() const {
+        return elementBytes + slackBytes + tableBytes + controlBlockBytes + figureHeapBytes
+            + allocatorOverheadBytes;
+    }
+};
+
+// Оценка блока управления фигуры из make_shared в libstdc++: указатель на
+// vtable и два счётчика. Фигура, созданная через new, имеет отдельный блок
+// управления, который эта оценка не учитывает.
+inline constexpr size_t ControlBlockBytes = sizeof(void*) + 2 * sizeof(int);
+
+namespace detail {
+
+inline thread_local size_t probedBytes = 0;
+
+// Обёртка, запоминающая размер запроса. Она того же размера, что и A, поэтому
+// allocate_shared раскладывает блок так же, как с самим A; память берётся
+// из std::allocator, чтобы замер не попадал в счётчики A.
+template <class A>
+struct ProbeAllocator : A {
+    using value_type = typename std::allocator_traits<A>::value_type;
+
+    template <class U>
+    struct rebind {
+        using other = ProbeAllocator<typename std::allocator_traits<A>::template rebind_alloc<U>>;
+    };
+
+    explicit ProbeAllocator(const A& alloc) : A(alloc) {}
+
+    template <class B>
+    ProbeAllocator(const ProbeAllocator<B>& other) : A(static_cast<const B&>(other)) {}
+
+    value_type* allocate(size_t n) {
+        probedBytes = n * sizeof(value_type);
+        return std::allocator<value_type>().allocate(n);
+    }
+
+    void deallocate(value_type* p, size_t n) noexcept {
+        std::allocator<value_type>().deallocate(p, n);
+    }
+};
+
+}  // namespace detail
+
+// Сколько байт сверх n * sizeof(T) запрашивает allocate_shared<T[]>(alloc, n):
+// счётчики, копия аллокатора и выравнивание до размера элемента. От n не
+// зависит, поэтому измеряется один раз на пару типов.
+template <class T, class A>
+size_t sharedArrayControlBytes(const A& alloc) {
+    static const size_t bytes = [&] {
+        std::allocate_shared<T[]>(detail::ProbeAllocator<A>(alloc), 1);
+        return detail::probedBytes - sizeof(T);
+    }();
+    return bytes;
+}
+
+// Сколько malloc из glibc добавляет к запросу: 8 байт заголовка,
+// выравнивание до 16 и минимальный блок в 32 байта.
+inline size_t mallocOverhead(size_t request) {
+    size_t block = (request + sizeof(size_t) + 15) & ~size_t(15);
+    if (block < 32) block = 32;
+    return block - request;
+}
+
+struct AllocationCounts {
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> deallocations{0};
+    std::atomic<size_t> bytes{0};
+    std::atomic<size_t> liveBytes{0};
+};
+
+// Аллокатор для Array, считающий выделения в общий AllocationCounts.
+template <class T>
+class CountingAllocator {
+public:
+    using value_type = T;
+
+    explicit CountingAllocator(AllocationCounts* counts) noexcept : counts(counts) {}
+
+    template <class U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept : counts(other.counts) {}
+
+    T* allocate(size_t n) {
+        T* p = std::allocator<T>().allocate(n);
+        counts->allocations += 1;
+        counts->bytes += n * sizeof(T);
+        counts->liveBytes += n * sizeof(T);
+        return p;
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        counts->deallocations += 1;
+        counts->liveBytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <class U>
+    bool operator==(const CountingAllocator<U>& other) const noexcept {
+        return counts == other.counts;
+    }
+
+private:
+    template <class U>
+    friend class CountingAllocator;
+
+    AllocationCounts* counts;
+};
+
+#endif
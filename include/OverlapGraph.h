@@ -0,0 +1,193 @@
+#ifndef OVERLAP_GRAPH_H
+#define OVERLAP_GRAPH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Array.h"
+#include "KahanSum.h"
+#include "Quad.h"
+
+struct FigureCluster {
+    std::vector<size_t> members;  // индексы в исходном Array по возрастанию
+    double surface{0.0};          // сумма площадей участников (перекрытия не вычитаются)
+    double minX, minY, maxX, maxY;
+};
+
+struct ClusterResult {
+    std::vector<size_t> component;                 // номер кластера элемента Array (max — пустой элемент)
+    std::vector<FigureCluster> clusters;           // в порядке первого участника
+    std::vector<std::pair<size_t, size_t>> edges;  // пары касающихся или перекрывающихся фигур
+};
+
+// Граф перекрытий/касаний фигур и его компоненты связности.
+// Широкая фаза: фигуры сортируются по minX, и каждая сравнивается только с теми,
+// чей minX не больше её maxX и чьи интервалы по Y пересекаются. Узкая фаза —
+// точная проверка четырёхугольников по вершинам. Рёбра сразу объединяются в
+// lock-free системе непересекающихся множеств, общей для всех потоков.
+class OverlapGraph {
+public:
+    explicit OverlapGraph(unsigned threads = 0, double eps = 1e-9)
+        : threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())), eps(eps) {}
+
+    template <class E, class A>
+    ClusterResult cluster(const Array<E, A>& figures, bool keepEdges = true) const {
+        auto quads = extractQuads(figures);
+        std::sort(quads.begin(), quads.end(), [](const Quad& a, const Quad& b) { return a.minX < b.minX; });
+        if (quads.size() >= std::numeric_limits<uint32_t>::max())
+            throw std::length_error("Too many figures for OverlapGraph");
+
+        size_t n = quads.size();
+        auto parent = std::make_unique<std::atomic<uint32_t>[]>(n);
+        for (size_t i = 0; i < n; ++i) parent[i].store(uint32_t(i), std::memory_order_relaxed);
+
+        std::vector<std::vector<std::pair<size_t, size_t>>> found(threads);
+        std::atomic<size_t> next{0};
+        constexpr size_t Block = 256;
+
+        auto work = [&](unsigned worker) {
+            for (size_t begin; (begin = next.fetch_add(Block)) < n;) {
+                for (size_t i = begin; i < std::min(n, begin + Block); ++i) {
+                    const Quad& a = quads[i];
+                    for (size_t j = i + 1; j < n && quads[j].minX <= a.maxX + eps; ++j) {
+                        const Quad& b = quads[j];
+                        if (b.minY > a.maxY + eps || a.minY > b.maxY + eps) continue;
+                        if (!intersects(a, b)) continue;
+                        unite(parent.get(), uint32_t(i), uint32_t(j));
+                        if (keepEdges)
+                            found[worker].emplace_back(std::min(a.index, b.index), std::max(a.index, b.index));
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work, t);
+        work(0);
+        for (auto& t : pool) t.join();
+
+        return collect(figures, quads, parent.get(), found);
+    }
+
+private:
+    unsigned threads;
+    double eps;
+
+    // Поиск корня с делением пути пополам; CAS может проиграть гонку, это безопасно.
+    static uint32_t find(std::atomic<uint32_t>* parent, uint32_t x) {
+        while (true) {
+            uint32_t p = parent[x].load();
+            if (p == x) return x;
+            uint32_t gp = parent[p].load();
+            if (p != gp) parent[x].compare_exchange_weak(p, gp);
+            x = gp;
+        }
+    }
+
+    // Корень с большим индексом подвешивается к меньшему, поэтому циклов не бывает.
+    static void unite(std::atomic<uint32_t>* parent, uint32_t a, uint32_t b) {
+        while (true) {
+            a = find(parent, a);
+            b = find(parent, b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            uint32_t expected = a;
+            if (parent[a].compare_exchange_strong(expected, b)) return;
+        }
+    }
+
+    double cross(double ax, double ay, double bx, double by, double cx, double cy) const {
+        double v = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+        return std::abs(v) <= eps ? 0.0 : v;
+    }
+
+    bool onSegment(double ax, double ay, double bx, double by, double px, double py) const {
+        return std::min(ax, bx) - eps <= px && px <= std::max(ax, bx) + eps
+            && std::min(ay, by) - eps <= py && py <= std::max(ay, by) + eps;
+    }
+
+    // Пересечение отрезков с учётом касания концами и коллинеарного наложения.
+    bool segmentsTouch(double ax, double ay, double bx, double by,
+                       double cx, double cy, double dx, double dy) const {
+        double d1 = cross(cx, cy, dx, dy, ax, ay);
+        double d2 = cross(cx, cy, dx, dy, bx, by);
+        double d3 = cross(ax, ay, bx, by, cx, cy);
+        double d4 = cross(ax, ay, bx, by, dx, dy);
+        if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0)))
+            return true;
+        return (d1 == 0 && onSegment(cx, cy, dx, dy, ax, ay))
+            || (d2 == 0 && onSegment(cx, cy, dx, dy, bx, by))
+            || (d3 == 0 && onSegment(ax, ay, bx, by, cx, cy))
+            || (d4 == 0 && onSegment(ax, ay, bx, by, dx, dy));
+    }
+
+    static bool containsPoint(const Quad& q, double px, double py) {
+        bool inside = false;
+        for (int i = 0, j = 3; i < 4; j = i++) {
+            if ((q.y[i] > py) != (q.y[j] > py)) {
+                double x = q.x[i] + (py - q.y[i]) * (q.x[j] - q.x[i]) / (q.y[j] - q.y[i]);
+                if (px < x) inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    bool intersects(const Quad& a, const Quad& b) const {
+        for (int i = 0, pi = 3; i < 4; pi = i++)
+            for (int j = 0, pj = 3; j < 4; pj = j++)
+                if (segmentsTouch(a.x[pi], a.y[pi], a.x[i], a.y[i], b.x[pj], b.y[pj], b.x[j], b.y[j]))
+                    return true;
+        return containsPoint(a, b.x[0], b.y[0]) || containsPoint(b, a.x[0], a.y[0]);
+    }
+
+    template <class E, class A>
+    ClusterResult collect(const Array<E, A>& figures, const std::vector<Quad>& quads, std::atomic<uint32_t>* parent,
+                          std::vector<std::vector<std::pair<size_t, size_t>>>& found) const {
+        ClusterResult result;
+        constexpr size_t None = std::numeric_limits<size_t>::max();
+        result.component.assign(figures.getSize(), None);
+
+        // Сначала корень каждого элемента, затем нумерация в порядке индексов Array.
+        std::vector<uint32_t> rootOf(figures.getSize(), 0);
+        for (size_t q = 0; q < quads.size(); ++q) rootOf[quads[q].index] = find(parent, uint32_t(q));
+
+        std::vector<size_t> idOfRoot(quads.size(), None);
+        std::vector<KahanSum> sums;
+        std::vector<size_t> quadAt(figures.getSize(), None);
+        for (size_t q = 0; q < quads.size(); ++q) quadAt[quads[q].index] = q;
+
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            if (quadAt[i] == None) continue;
+            const Quad& q = quads[quadAt[i]];
+            size_t& id = idOfRoot[rootOf[i]];
+            if (id == None) {
+                id = result.clusters.size();
+                result.clusters.push_back(FigureCluster{{}, 0.0, q.minX, q.minY, q.maxX, q.maxY});
+                sums.emplace_back();
+            }
+            FigureCluster& c = result.clusters[id];
+            c.members.push_back(i);
+            c.minX = std::min(c.minX, q.minX);
+            c.minY = std::min(c.minY, q.minY);
+            c.maxX = std::max(c.maxX, q.maxX);
+            c.maxY = std::max(c.maxY, q.maxY);
+            sums[id].add(figureOf(figures.unchecked(i)).surface());
+            result.component[i] = id;
+        }
+        for (size_t id = 0; id < sums.size(); ++id) result.clusters[id].surface = sums[id].value();
+
+        for (auto& part : found) result.edges.insert(result.edges.end(), part.begin(), part.end());
+        std::sort(result.edges.begin(), result.edges.end());
+        return result;
+    }
+};
+
+#endif
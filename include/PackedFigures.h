@@ -0,0 +1,129 @@
+#ifndef PACKED_FIGURES_H
+#define PACKED_FIGURES_H
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "Array.h"
+#include "Square.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+
+enum class PackedKind : uint8_t { Square, Rectangle, Trapezoid };
+
+// Вершины одной фигуры подряд, без указателей: 32 байта для float, 64 для double.
+template <IsScalar T>
+struct PackedQuad {
+    T x[4];
+    T y[4];
+};
+
+// Плоское хранилище фигур: все вершины лежат в одном векторе, тип фигуры —
+// в параллельном векторе байтов. Figure<float> экономит лишь половину каждой
+// Point, а каждая вершина там по-прежнему отдельный блок кучи; здесь float
+// действительно вдвое сокращает объём, который читает проход по коллекции.
+// Вычисления идут в double по тем же формулам, что и в классах фигур.
+// index — позиция фигуры в исходном Array (пустые элементы пропускаются).
+template <IsScalar T>
+class PackedFigures {
+public:
+    template <class E, class A>
+    static PackedFigures from(const Array<E, A>& figures) {
+        PackedFigures packed;
+        packed.reserve(figures.getSize());
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            const E& e = figures.unchecked(i);
+            if constexpr (requires { e == nullptr; }) {
+                if (e == nullptr) continue;
+            }
+            packed.add(figureOf(e), i);
+        }
+        return packed;
+    }
+
+    template <IsScalar U>
+    void add(const Figure<U>& fig, size_t sourceIndex) {
+        PackedQuad<T> q;
+        for (size_t v = 0; v < 4; ++v) {
+            auto p = fig.vertex(v);
+            q.x[v] = static_cast<T>(p.x);
+            q.y[v] = static_cast<T>(p.y);
+        }
+        kinds.push_back(kindOf(fig));
+        quads.push_back(q);
+        index.push_back(sourceIndex);
+    }
+
+    void reserve(size_t n) {
+        quads.reserve(n);
+        kinds.reserve(n);
+        index.reserve(n);
+    }
+
+    size_t getSize() const {
+        return quads.size();
+    }
+
+    PackedKind kind(size_t i) const {
+        return kinds[i];
+    }
+
+    Point<T> vertex(size_t i, size_t v) const {
+        return Point<T>{quads[i].x[v], quads[i].y[v]};
+    }
+
+    double surface(size_t i) const {
+        const PackedQuad<T>& q = quads[i];
+        auto dist = [&](int a, int b) {
+            double dx = double(q.x[a]) - double(q.x[b]);
+            double dy = double(q.y[a]) - double(q.y[b]);
+            return std::sqrt(dx * dx + dy * dy);
+        };
+        switch (kinds[i]) {
+            case PackedKind::Square: return dist(0, 1) * dist(0, 1);
+            case PackedKind::Rectangle: return dist(0, 1) * dist(1, 2);
+            case PackedKind::Trapezoid: return (dist(0, 1) + dist(2, 3)) * std::abs(double(q.y[0]) - double(q.y[2])) / 2.0;
+        }
+        return 0.0;
+    }
+
+    Point<double> center(size_t i) const {
+        const PackedQuad<T>& q = quads[i];
+        double cx = 0, cy = 0;
+        for (size_t v = 0; v < 4; ++v) {
+            cx += q.x[v];
+            cy += q.y[v];
+        }
+        return Point<double>{cx / 4, cy / 4};
+    }
+
+    double totalSurface() const {
+        KahanSum sum;
+        for (size_t i = 0; i < quads.size(); ++i) sum.add(surface(i));
+        return sum.value();
+    }
+
+    // Занятая векторами память, включая резерв.
+    size_t bytes() const {
+        return quads.capacity() * sizeof(PackedQuad<T>) + kinds.capacity() * sizeof(PackedKind)
+            + index.capacity() * sizeof(size_t);
+    }
+
+    std::vector<size_t> index;
+
+private:
+    std::vector<PackedQuad<T>> quads;
+    std::vector<PackedKind> kinds;
+
+    template <IsScalar U>
+    static PackedKind kindOf(const Figure<U>& fig) {
+        if (dynamic_cast<const Square<U>*>(&fig)) return PackedKind::Square;
+        if (dynamic_cast<const Rectangle<U>*>(&fig)) return PackedKind::Rectangle;
+        if (dynamic_cast<const Trapezoid<U>*>(&fig)) return PackedKind::Trapezoid;
+        throw std::invalid_argument("PackedFigures: unsupported figure type");
+    }
+};
+
+#endif
@@ -29,12 +29,15 @@ public:
         return Point<T>(x - other.x, y - other.y);
     }
 
+    // Координаты могут храниться во float, но вычисления всегда идут в double.
     double distanceTo(const Point& other) const {
-        return std::sqrt((x - other.x)*(x - other.x) + (y - other.y)*(y - other.y));
+        double dx = double(x) - double(other.x);
+        double dy = double(y) - double(other.y);
+        return std::sqrt(dx * dx + dy * dy);
     }
 
     double dot(const Point& other) const {
-        return x * other.x + y * other.y;
+        return double(x) * double(other.x) + double(y) * double(other.y);
     }
 
     friend std::istream& operator>>(std::istream& is, Point<T>& p) {
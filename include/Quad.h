@@ -0,0 +1,45 @@
+#ifndef QUAD_H
+#define QUAD_H
+
+#include <algorithm>
+#include <vector>
+
+#include "Array.h"
+
+// Плоская копия вершин четырёхугольника для горячих циклов без виртуальных
+// вызовов и лишних разыменований. index — позиция фигуры в исходном Array.
+struct Quad {
+    double x[4];
+    double y[4];
+    double minX, minY, maxX, maxY;
+    size_t index;
+};
+
+template <class E, class A>
+std::vector<Quad> extractQuads(const Array<E, A>& figures) {
+    std::vector<Quad> quads;
+    quads.reserve(figures.getSize());
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        const E& e = figures.unchecked(i);
+        if constexpr (requires { e == nullptr; }) {
+            if (e == nullptr) continue;
+        }
+        const auto& fig = figureOf(e);
+        if (fig.vertexCount() != 4) continue;
+        Quad q;
+        for (size_t v = 0; v < 4; ++v) {
+            auto p = fig.vertex(v);
+            q.x[v] = p.x;
+            q.y[v] = p.y;
+        }
+        q.minX = *std::min_element(q.x, q.x + 4);
+        q.maxX = *std::max_element(q.x, q.x + 4);
+        q.minY = *std::min_element(q.y, q.y + 4);
+        q.maxY = *std::max_element(q.y, q.y + 4);
+        q.index = i;
+        quads.push_back(q);
+    }
+    return quads;
+}
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Array.h"
+#include "Point.h"
+#include "Quad.h"
+
+// Регулярная сетка: ячейка (col, row) покрывает
+// [originX + col*cellSize, originX + (col+1)*cellSize) x [originY + row*cellSize, ...).
+struct RasterGrid {
+    double originX{0.0};
+    double originY{0.0};
+    double cellSize{1.0};
+    size_t width{0};
+    size_t height{0};
+};
+
+// Растеризация набора четырёхугольников в сетку, которую передаёт вызывающий.
+// Вершины один раз копируются в плоский буфер, затем фигуры раскладываются по
+// тайлам по ограничивающему прямоугольнику, и потоки разбирают тайлы целиком:
+// каждая ячейка пишется только одним потоком, поэтому блокировки не нужны.
+class Rasterizer {
+public:
+    explicit Rasterizer(const RasterGrid& grid, unsigned threads = 0, size_t tileSize = 64)
+        : grid(grid), threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+          tileSize(tileSize) {
+        if (grid.cellSize <= 0 || tileSize == 0)
+            throw std::invalid_argument("Cell size and tile size must be positive");
+    }
+
+    // Число фигур, содержащих центр каждой ячейки.
+    template <class E, class A>
+    void coverageCounts(const Array<E, A>& figures, std::span<uint32_t> counts) const {
+        checkBuffer(counts.size());
+        std::fill(counts.begin(), counts.end(), 0u);
+        auto quads = extractQuads(figures);
+        run(quads, 1, [&](size_t, size_t col, size_t row, uint64_t) {
+            ++counts[row * grid.width + col];
+        }, [](size_t, size_t) {});
+    }
+
+    // Доля площади ячейки, покрытая объединением фигур, по samples x samples
+    // подвыборкам на ячейку (samples от 1 до 8).
+    template <class E, class A>
+    void coverageFraction(const Array<E, A>& figures, std::span<float> fraction, int samples = 4) const {
+        checkBuffer(fraction.size());
+        if (samples < 1 || samples > 8) throw std::invalid_argument("Samples must be in [1, 8]");
+        auto quads = extractQuads(figures);
+        std::vector<std::vector<uint64_t>> masks(threads, std::vector<uint64_t>(tileSize * tileSize, 0));
+        float norm = 1.0f / float(samples * samples);
+
+        // Подвыборки копятся в битовой маске тайла у своего потока и
+        // сбрасываются в сетку после того, как тайл обработан целиком.
+        run(quads, samples, [&](size_t worker, size_t col, size_t row, uint64_t bit) {
+            masks[worker][(row % tileSize) * tileSize + col % tileSize] |= bit;
+        }, [&](size_t worker, size_t tile) {
+            auto& mask = masks[worker];
+            size_t tx = tile % tilesX(), ty = tile / tilesX();
+            for (size_t r = ty * tileSize; r < std::min(grid.height, (ty + 1) * tileSize); ++r)
+                for (size_t c = tx * tileSize; c < std::min(grid.width, (tx + 1) * tileSize); ++c) {
+                    uint64_t& m = mask[(r % tileSize) * tileSize + c % tileSize];
+                    fraction[r * grid.width + c] = float(std::popcount(m)) * norm;
+                    m = 0;
+                }
+        });
+    }
+
+private:
+    RasterGrid grid;
+    unsigned threads;
+    size_t tileSize;
+
+    size_t tilesX() const { return (grid.width + tileSize - 1) / tileSize; }
+    size_t tilesY() const { return (grid.height + tileSize - 1) / tileSize; }
+
+    void checkBuffer(size_t size) const {
+        if (size != grid.width * grid.height)
+            throw std::invalid_argument("Grid buffer size does not match width * height");
+    }
+
+    // Раскладывает фигуры по тайлам и вызывает emit(worker, col, row, sampleBit)
+    // для каждой покрытой подвыборки, затем done(worker, tile) по окончании тайла.
+    template <class Emit, class Done>
+    void run(const std::vector<Quad>& quads, int samples, Emit emit, Done done) const {
+        size_t tx = tilesX(), ty = tilesY();
+        if (tx == 0 || ty == 0) return;
+        double tileExtent = grid.cellSize * tileSize;
+
+        std::vector<std::vector<uint32_t>> bins(tx * ty);
+        for (size_t i = 0; i < quads.size(); ++i) {
+            const Quad& q = quads[i];
+            double c0 = std::floor((q.minX - grid.originX) / tileExtent);
+            double c1 = std::floor((q.maxX - grid.originX) / tileExtent);
+            double r0 = std::floor((q.minY - grid.originY) / tileExtent);
+            double r1 = std::floor((q.maxY - grid.originY) / tileExtent);
+            if (c1 < 0 || r1 < 0 || c0 >= double(tx) || r0 >= double(ty)) continue;
+            size_t cBegin = size_t(std::max(c0, 0.0)), cEnd = size_t(std::min(c1, double(tx - 1)));
+            size_t rBegin = size_t(std::max(r0, 0.0)), rEnd = size_t(std::min(r1, double(ty - 1)));
+            for (size_t r = rBegin; r <= rEnd; ++r)
+                for (size_t c = cBegin; c <= cEnd; ++c)
+                    bins[r * tx + c].push_back(uint32_t(i));
+        }
+
+        std::atomic<size_t> next{0};
+        auto work = [&](size_t worker) {
+            for (size_t tile; (tile = next.fetch_add(1)) < bins.size();) {
+                rasterTile(quads, bins[tile], tile, samples, worker, emit);
+                done(worker, tile);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work, t);
+        work(0);
+        for (auto& t : pool) t.join();
+    }
+
+    template <class Emit>
+    void rasterTile(const std::vector<Quad>& quads, const std::vector<uint32_t>& bin,
+                    size_t tile, int samples, size_t worker, Emit& emit) const {
+        size_t s = size_t(samples);
+        double step = grid.cellSize / samples;
+        size_t col0 = (tile % tilesX()) * tileSize, row0 = (tile / tilesX()) * tileSize;
+        size_t col1 = std::min(grid.width, col0 + tileSize), row1 = std::min(grid.height, row0 + tileSize);
+
+        for (uint32_t index : bin) {
+            const Quad& q = quads[index];
+            // Строки подвыборок, чьи центры попадают в [minY, maxY].
+            double first = std::max(std::ceil((q.minY - grid.originY) / step - 0.5), double(row0 * s));
+            double last = std::min(std::floor((q.maxY - grid.originY) / step - 0.5) + 1, double(row1 * s));
+            if (last <= first) continue;
+            size_t sr0 = size_t(first), sr1 = size_t(last);
+
+            for (size_t sr = sr0; sr < sr1; ++sr) {
+                double y = grid.originY + (sr + 0.5) * step;
+                double xs[4];
+                int count = 0;
+                for (int i = 0, j = 3; i < 4; j = i++) {
+                    if ((q.y[i] > y) != (q.y[j] > y))
+                        xs[count++] = q.x[i] + (y - q.y[i]) * (q.x[j] - q.x[i]) / (q.y[j] - q.y[i]);
+                }
+                for (int i = 1; i < count; ++i)
+                    for (int j = i; j > 0 && xs[j] < xs[j - 1]; --j) std::swap(xs[j], xs[j - 1]);
+
+                for (int k = 0; k + 1 < count; k += 2) {
+                    double a = std::max(std::ceil((xs[k] - grid.originX) / step - 0.5), double(col0 * s));
+                    double b = std::min(std::ceil((xs[k + 1] - grid.originX) / step - 0.5), double(col1 * s));
+                    if (b <= a) continue;
+                    size_t sc0 = size_t(a), sc1 = size_t(b);
+                    for (size_t sc = sc0; sc < sc1; ++sc)
+                        emit(worker, sc / s, sr / s, uint64_t(1) << ((sr % s) * s + sc % s));
+                }
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,574 @@
+#ifndef SHARDED_FIGURES_H
+#define SHARDED_FIGURES_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Array.h"
+#include "KahanSum.h"
+#include "Square.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+
+enum class FlatType : uint32_t {
+    Square,
+    Rectangle,
+    Trapezoid
+};
+
+// Фигура без указателей: её можно положить в разделяемую память и читать
+// из другого процесса.
+struct FlatFigure {
+    FlatType type;
+    double x[4];
+    double y[4];
+};
+
+// Те же формулы, что и в surface()/center() соответствующих классов.
+inline double flatSurface(const FlatFigure& f) {
+    auto dist = [&](int a, int b) { return std::hypot(f.x[a] - f.x[b], f.y[a] - f.y[b]); };
+    switch (f.type) {
+        case FlatType::Square: return dist(0, 1) * dist(0, 1);
+        case FlatType::Rectangle: return dist(0, 1) * dist(1, 2);
+        case FlatType::Trapezoid: return (dist(0, 1) + dist(2, 3)) * std::abs(f.y[0] - f.y[2]) / 2.0;
+    }
+    return 0.0;
+}
+
+inline Point<double> flatCenter(const FlatFigure& f) {
+    return Point<double>{(f.x[0] + f.x[1] + f.x[2] + f.x[3]) / 4, (f.y[0] + f.y[1] + f.y[2] + f.y[3]) / 4};
+}
+
+
+// Коллекция, разложенная по шардам в сегментах POSIX shared memory. Каждый
+// шард обслуживает отдельный процесс-воркер: он владеет сегментом со своими
+// записями и индексом id -> слот, сам добавляет, удаляет и расширяет сегмент.
+// Координатор хранит только число записей в шардах и ограниченный буфер ещё
+// не отправленных добавлений, поэтому его память не растёт вместе с данными.
+// Запросы рассылаются всем воркерам через unix-сокеты, затем собираются ответы.
+// Добавление идёт в наименьший шард. Удаление рассылается всем шардам, так как
+// id знает только владелец, и при перекосе больше чем на одну запись переносит
+// последнюю запись наибольшего шарда в наименьший.
+//
+// Воркер — это тот же исполняемый файл, перезапущенный через /proc/self/exe
+// с флагом WorkerFlag: после exec у него нет ни памяти координатора, ни его
+// дескрипторов (все создаются с O_CLOEXEC), кроме своего сокета. Поэтому main()
+// программы, использующей ShardedFigures, должен первым делом вызвать
+// runWorkerFromArgs(). Имя сегмента удаляется сразу после запуска воркера, и
+// при падении любого из процессов сегменты не остаются в /dev/shm.
+// Если воркер упал посреди запроса, экземпляр больше не принимает запросов:
+// в сокетах остальных шардов могли остаться непрочитанные ответы.
+class ShardedFigures {
+public:
+    using TypeCounts = std::array<size_t, 3>;
+
+    static constexpr const char* WorkerFlag = "--shard-worker";
+
+    explicit ShardedFigures(size_t shardCount) {
+        if (shardCount == 0) throw std::invalid_argument("At least one shard is required");
+        if (std::getenv(WorkerEnv))
+            throw std::logic_error("Shard worker reached main(): call ShardedFigures::runWorkerFromArgs first");
+        static std::atomic<unsigned> instances{0};
+        std::string prefix = "/homework4-" + std::to_string(getpid()) + "-" + std::to_string(instances++) + "-";
+        shards.resize(shardCount);
+        try {
+            for (size_t s = 0; s < shardCount; ++s) {
+                shards[s].name = prefix + std::to_string(s);
+                spawn(s);
+            }
+        } catch (...) {
+            shutdown();
+            throw;
+        }
+    }
+
+    ShardedFigures(const ShardedFigures&) = delete;
+    ShardedFigures& operator=(const ShardedFigures&) = delete;
+
+    ~ShardedFigures() {
+        shutdown();
+    }
+
+    // Точка входа воркера. Возвращает false, если процесс запущен не как воркер
+    // и main() должен продолжить обычную работу.
+    static bool runWorkerFromArgs(int argc, char** argv) {
+        if (argc != 4 || std::strcmp(argv[1], WorkerFlag) != 0) return false;
+        try {
+            serve(argv[2], std::stoi(argv[3]));
+        } catch (...) {
+            _exit(1);
+        }
+        return true;
+    }
+
+    // Возвращает устойчивый идентификатор фигуры для remove() и результатов запросов.
+    template <IsScalar T>
+    size_t add(const Figure<T>& fig) {
+        FlatFigure flat{typeOf(fig), {}, {}};
+        for (size_t v = 0; v < 4; ++v) {
+            auto p = fig.vertex(v);
+            flat.x[v] = p.x;
+            flat.y[v] = p.y;
+        }
+        size_t id = nextId++;
+        append(smallestShard(), Record{flat, uint64_t(id)});
+        return id;
+    }
+
+    template <class E, class A>
+    void addAll(const Array<E, A>& figures) {
+        figures.forEach([&](const E& e) {
+            if constexpr (requires { e == nullptr; }) {
+                if (e == nullptr) return;
+            }
+            add(figureOf(e));
+        });
+    }
+
+    void remove(size_t id) {
+        if (id >= nextId) throw std::out_of_range("Unknown figure id");
+        size_t owner = shards.size(), s = 0;
+        gather(Query{Op::Remove, uint64_t(id), {}}, [&](const Shard& shard) {
+            if (receive<uint64_t>(shard)) owner = s;
+            ++s;
+        });
+        if (owner == shards.size()) throw std::out_of_range("Unknown figure id");
+        --shards[owner].count;
+
+        size_t small = smallestShard(), large = largestShard();
+        if (count(large) > count(small) + 1) {
+            Record moved = request<Record>(large, Query{Op::PopLast, 0, {}});
+            --shards[large].count;
+            append(small, moved);
+        }
+    }
+
+    size_t getSize() const {
+        size_t total = 0;
+        for (const auto& shard : shards) total += shard.count;
+        return total;
+    }
+
+    size_t getShardCount() const {
+        return shards.size();
+    }
+
+    size_t shardSize(size_t s) const {
+        return count(s);
+    }
+
+    double totalSurface() {
+        KahanSum total;
+        gather(Query{Op::Total, 0, {}}, [&](const Shard& shard) { total.add(receive<double>(shard)); });
+        return total.value();
+    }
+
+    TypeCounts typeCounts() {
+        TypeCounts total{};
+        gather(Query{Op::Counts, 0, {}}, [&](const Shard& shard) {
+            auto part = receive<TypeCounts>(shard);
+            for (size_t t = 0; t < total.size(); ++t) total[t] += part[t];
+        });
+        return total;
+    }
+
+    // k фигур с наибольшей площадью: пары (площадь, id) по убыванию площади,
+    // при равной площади — по возрастанию id.
+    std::vector<std::pair<double, size_t>> topK(size_t k) {
+        std::vector<std::pair<double, size_t>> merged;
+        gather(Query{Op::TopK, uint64_t(k), {}}, [&](const Shard& shard) {
+            size_t n = receive<uint64_t>(shard);
+            for (size_t i = 0; i < n; ++i) {
+                auto [surface, id] = receive<std::pair<double, uint64_t>>(shard);
+                merged.emplace_back(surface, id);
+            }
+        });
+        std::sort(merged.begin(), merged.end(), byTopOrder);
+        if (merged.size() > k) merged.resize(k);
+        return merged;
+    }
+
+    // id фигур, чей центр лежит в [minX, maxX] x [minY, maxY], по возрастанию.
+    std::vector<size_t> inRegion(double minX, double minY, double maxX, double maxY) {
+        std::vector<size_t> ids;
+        gather(Query{Op::Region, 0, {minX, minY, maxX, maxY}}, [&](const Shard& shard) {
+            size_t n = receive<uint64_t>(shard);
+            for (size_t i = 0; i < n; ++i) ids.push_back(receive<uint64_t>(shard));
+        });
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+private:
+    enum class Op : uint32_t { Quit, Total, Counts, TopK, Region, Append, Remove, PopLast };
+
+    // k — число фигур для TopK, число записей, следующих за Append, или id для Remove.
+    struct Query {
+        Op op;
+        uint64_t k;
+        double region[4];
+    };
+
+    // Запись сегмента: id хранится рядом с фигурой, чтобы воркер мог
+    // упорядочить равные площади и вернуть id без участия координатора.
+    struct Record {
+        FlatFigure figure;
+        uint64_t id;
+    };
+
+    static constexpr const char* WorkerEnv = "HOMEWORK4_SHARD_WORKER";
+    static constexpr uint64_t ReadyMagic = 0x5348415244524459;  // "SHARDRDY"
+    static constexpr int ReadyTimeoutMs = 10000;
+    static constexpr size_t AppendBatch = 1024;  // записей в буфере координатора на шард
+    static constexpr size_t InitialCapacity = 64;
+
+    struct Shard {
+        std::string name;
+        pid_t worker{-1};
+        int channel{-1};
+        size_t count{0};              // записей в шарде, включая ещё не отправленные
+        std::vector<Record> pending;  // добавления, ещё не отправленные воркеру
+    };
+
+    // Сегмент шарда в процессе воркера: записи подряд и индекс id -> слот.
+    // Удаление переносит в освободившийся слот последнюю запись.
+    struct Segment {
+        int fd{-1};
+        Record* items{nullptr};
+        size_t count{0};
+        size_t capacity{0};
+        std::unordered_map<uint64_t, size_t> slots;
+
+        // Сегмент растёт вдвое: ftruncate и новое отображение вместо старого.
+        void reserve(size_t n) {
+            if (n <= capacity) return;
+            size_t grown = std::max({n, 2 * capacity, InitialCapacity});
+            size_t bytes = grown * sizeof(Record);
+            if (ftruncate(fd, off_t(bytes)) != 0) fail("ftruncate");
+            void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (base == MAP_FAILED) fail("mmap");
+            if (items) munmap(items, capacity * sizeof(Record));
+            items = static_cast<Record*>(base);
+            capacity = grown;
+        }
+
+        // Записи уже прочитаны в items[count, count + n), осталось их проиндексировать.
+        void commit(size_t n) {
+            for (size_t i = 0; i < n; ++i) slots[items[count + i].id] = count + i;
+            count += n;
+        }
+
+        bool erase(uint64_t id) {
+            auto it = slots.find(id);
+            if (it == slots.end()) return false;
+            size_t slot = it->second;
+            slots.erase(it);
+            if (slot != --count) {
+                items[slot] = items[count];
+                slots[items[slot].id] = slot;
+            }
+            return true;
+        }
+
+        Record popLast() {
+            if (count == 0) throw std::logic_error("PopLast on an empty shard");
+            Record last = items[--count];
+            slots.erase(last.id);
+            return last;
+        }
+    };
+
+    std::vector<Shard> shards;
+    size_t nextId{0};
+    bool broken{false};
+
+    static bool byTopOrder(const std::pair<double, uint64_t>& a, const std::pair<double, uint64_t>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    }
+
+    static void fail(const std::string& what) {
+        throw std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    size_t count(size_t s) const {
+        return shards[s].count;
+    }
+
+    size_t smallestShard() const {
+        size_t best = 0;
+        for (size_t s = 1; s < shards.size(); ++s)
+            if (count(s) < count(best)) best = s;
+        return best;
+    }
+
+    size_t largestShard() const {
+        size_t best = 0;
+        for (size_t s = 1; s < shards.size(); ++s)
+            if (count(s) > count(best)) best = s;
+        return best;
+    }
+
+    template <IsScalar T>
+    static FlatType typeOf(const Figure<T>& fig) {
+        if (dynamic_cast<const Square<T>*>(&fig)) return FlatType::Square;
+        if (dynamic_cast<const Rectangle<T>*>(&fig)) return FlatType::Rectangle;
+        if (dynamic_cast<const Trapezoid<T>*>(&fig)) return FlatType::Trapezoid;
+        throw std::invalid_argument("Unsupported figure type for sharding");
+    }
+
+    // Добавления копятся и уходят воркеру пачкой: перед любым запросом к шарду
+    // или когда буфер заполнен.
+    void append(size_t s, const Record& record) {
+        Shard& shard = shards[s];
+        shard.pending.push_back(record);
+        ++shard.count;
+        if (shard.pending.size() == AppendBatch) exchange([&] { sendPending(shard); });
+    }
+
+    static void sendPending(Shard& shard) {
+        if (shard.pending.empty()) return;
+        Query query{Op::Append, uint64_t(shard.pending.size()), {}};
+        writeAll(shard.channel, &query, sizeof(query));
+        writeAll(shard.channel, shard.pending.data(), shard.pending.size() * sizeof(Record));
+        shard.pending.clear();
+    }
+
+    // send с MSG_NOSIGNAL: упавший воркер даёт ошибку, а не SIGPIPE координатору.
+    static void writeAll(int fd, const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) fail("write to shard worker");
+            p += n;
+            size -= size_t(n);
+        }
+    }
+
+    static bool readAll(int fd, void* data, size_t size) {
+        char* p = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t n = read(fd, p, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= size_t(n);
+        }
+        return true;
+    }
+
+    // Любой обмен с воркерами. Сбой шарда оставляет несобранные ответы в
+    // сокетах, поэтому экземпляр помечается сломанным и дальнейшие запросы отклоняются.
+    template <class F>
+    void exchange(F&& body) {
+        if (broken) throw std::runtime_error("ShardedFigures is unusable after a shard worker failure");
+        try {
+            body();
+        } catch (...) {
+            broken = true;
+            throw;
+        }
+    }
+
+    // Рассылает запрос вслед за накопленными добавлениями и по очереди читает ответы шардов.
+    template <class F>
+    void gather(const Query& query, F&& readShard) {
+        exchange([&] {
+            for (auto& shard : shards) {
+                sendPending(shard);
+                writeAll(shard.channel, &query, sizeof(query));
+            }
+            for (auto& shard : shards) readShard(shard);
+        });
+    }
+
+    template <class V>
+    V request(size_t s, const Query& query) {
+        V value{};
+        exchange([&] {
+            sendPending(shards[s]);
+            writeAll(shards[s].channel, &query, sizeof(query));
+            value = receive<V>(shards[s]);
+        });
+        return value;
+    }
+
+    template <class V>
+    static V receive(const Shard& shard) {
+        V value;
+        if (!readAll(shard.channel, &value, sizeof(value))) throw std::runtime_error("Shard worker " + shard.name + " died");
+        return value;
+    }
+
+    // Сегмент создаётся до запуска воркера, а его имя удаляется, как только
+    // воркер открыл сегмент или не смог стартовать: дальше сегмент держит только
+    // дескриптор воркера, и ядро освободит его вместе с процессом.
+    void spawn(size_t s) {
+        Shard& shard = shards[s];
+        int fd = shm_open(shard.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) fail("shm_open " + shard.name);
+        close(fd);
+        try {
+            launch(shard);
+            awaitReady(shard);
+        } catch (...) {
+            shm_unlink(shard.name.c_str());
+            throw;
+        }
+        shm_unlink(shard.name.c_str());
+    }
+
+    // Всё для exec готовится до fork: в дочернем процессе многопоточной
+    // программы до exec допустимы только async-signal-safe вызовы.
+    static void launch(Shard& shard) {
+        int ends[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, ends) != 0) fail("socketpair");
+        std::string channel = std::to_string(ends[1]);
+        std::string marker = std::string(WorkerEnv) + "=1";
+        const char* args[] = {"/proc/self/exe", WorkerFlag, shard.name.c_str(), channel.c_str(), nullptr};
+        std::vector<char*> env;
+        for (char** e = environ; *e; ++e) env.push_back(*e);
+        env.push_back(marker.data());
+        env.push_back(nullptr);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(ends[0]);
+            close(ends[1]);
+            fail("fork");
+        }
+        if (pid == 0) {
+            // Снимаем O_CLOEXEC только с собственного конца сокета.
+            if (fcntl(ends[1], F_SETFD, 0) == 0) execve(args[0], const_cast<char* const*>(args), env.data());
+            _exit(127);
+        }
+        close(ends[1]);
+        shard.worker = pid;
+        shard.channel = ends[0];
+    }
+
+    // Воркер подтверждает, что открыл сегмент. Без этого программа, чей main()
+    // не вызывает runWorkerFromArgs, молча выполнила бы в воркере свой код.
+    static void awaitReady(Shard& shard) {
+        pollfd p{shard.channel, POLLIN, 0};
+        int ready;
+        do {
+            ready = poll(&p, 1, ReadyTimeoutMs);
+        } while (ready < 0 && errno == EINTR);
+        uint64_t magic = 0;
+        if (ready <= 0 || !readAll(shard.channel, &magic, sizeof(magic)) || magic != ReadyMagic) {
+            kill(shard.worker, SIGKILL);
+            throw std::runtime_error("Shard worker " + shard.name
+                + " did not start: main() must call ShardedFigures::runWorkerFromArgs");
+        }
+    }
+
+    // Цикл воркера: ведёт сегмент своего шарда и отвечает на запросы координатора.
+    static void serve(const std::string& name, int channel) {
+        Segment segment;
+        segment.fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (segment.fd < 0) _exit(1);
+        segment.reserve(InitialCapacity);
+        writeAll(channel, &ReadyMagic, sizeof(ReadyMagic));
+        Query query;
+        while (readAll(channel, &query, sizeof(query)) && query.op != Op::Quit) {
+            switch (query.op) {
+                case Op::Append:
+                    segment.reserve(segment.count + query.k);
+                    if (!readAll(channel, segment.items + segment.count, query.k * sizeof(Record))) _exit(1);
+                    segment.commit(query.k);
+                    break;
+                case Op::Remove: {
+                    uint64_t found = segment.erase(query.k);
+                    writeAll(channel, &found, sizeof(found));
+                    break;
+                }
+                case Op::PopLast: {
+                    Record last = segment.popLast();
+                    writeAll(channel, &last, sizeof(last));
+                    break;
+                }
+                default:
+                    answer(query, segment.items, segment.count, channel);
+            }
+        }
+        close(segment.fd);
+        close(channel);
+    }
+
+    static void answer(const Query& query, const Record* items, size_t n, int out) {
+        switch (query.op) {
+            case Op::Total: {
+                KahanSum total;
+                for (size_t i = 0; i < n; ++i) total.add(flatSurface(items[i].figure));
+                double value = total.value();
+                writeAll(out, &value, sizeof(value));
+                break;
+            }
+            case Op::Counts: {
+                TypeCounts counts{};
+                for (size_t i = 0; i < n; ++i) ++counts[size_t(items[i].figure.type)];
+                writeAll(out, &counts, sizeof(counts));
+                break;
+            }
+            case Op::TopK: {
+                std::vector<std::pair<double, uint64_t>> best;
+                best.reserve(n);
+                for (size_t i = 0; i < n; ++i) best.emplace_back(flatSurface(items[i].figure), items[i].id);
+                size_t k = std::min<size_t>(query.k, best.size());
+                std::partial_sort(best.begin(), best.begin() + k, best.end(), byTopOrder);
+                uint64_t size = k;
+                writeAll(out, &size, sizeof(size));
+                writeAll(out, best.data(), k * sizeof(best[0]));
+                break;
+            }
+            case Op::Region: {
+                std::vector<uint64_t> ids;
+                for (size_t i = 0; i < n; ++i) {
+                    auto c = flatCenter(items[i].figure);
+                    if (c.x >= query.region[0] && c.y >= query.region[1] && c.x <= query.region[2] && c.y <= query.region[3])
+                        ids.push_back(items[i].id);
+                }
+                uint64_t size = ids.size();
+                writeAll(out, &size, sizeof(size));
+                writeAll(out, ids.data(), ids.size() * sizeof(uint64_t));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // Имена сегментов уже удалены в spawn(): сегмент живёт, пока открыт воркером.
+    void shutdown() {
+        Query quit{Op::Quit, 0, {}};
+        for (auto& shard : shards)
+            if (shard.channel >= 0) send(shard.channel, &quit, sizeof(quit), MSG_NOSIGNAL);
+        for (auto& shard : shards) {
+            if (shard.channel >= 0) close(shard.channel);
+            if (shard.worker > 0) waitpid(shard.worker, nullptr, 0);
+            shard = Shard{};
+        }
+    }
+};
+
+#endif
@@ -47,17 +47,21 @@ public:
         if (is.rdbuf() == std::cin.rdbuf())
             std::cout << "Enter 4 square vertices separated by spaces (in x y format):\n";
 
-        for (auto& v : vertices) is >> *v;
+        readVertices(is);
         if (!validate()) throw std::invalid_argument("The entered points do not form a square!");
     }
 
+    void readVertices(std::istream& is) override {
+        for (auto& v : vertices) is >> *v;
+    }
+
     Point<T> center() const override {
-        T cx = 0, cy = 0;
+        double cx = 0, cy = 0;
         for (const auto& v : vertices) {
             cx += v->x;
             cy += v->y;
         }
-        return Point<T>{cx / 4, cy / 4};
+        return Point<T>{static_cast<T>(cx / 4), static_cast<T>(cy / 4)};
     }
 
     double surface() const override {
@@ -65,6 +69,19 @@ public:
         return a * a;
     }
 
+    size_t vertexCount() const override {
+        return n;
+    }
+
+    Point<T> vertex(size_t i) const override {
+        if (i >= std::size(vertices)) throw std::out_of_range("Vertex index out of range");
+        return *vertices[i];
+    }
+
+    Footprint footprint() const override {
+        return Footprint{sizeof(*this), n * sizeof(Point<T>), size_t(n)};
+    }
+
     operator double() const override {
         return surface();
     }
@@ -98,17 +115,18 @@ public:
                 if (*vertices[i] == *vertices[j])
                     return false;
 
-        T side = vertices[0]->distanceTo(*vertices[1]);
+        double side = vertices[0]->distanceTo(*vertices[1]);
+        double eps = this->tolerance();
         for (int i = 0; i < n; ++i) {
-            T current_side = vertices[i]->distanceTo(*vertices[(i + 1) % n]);
-            if (std::abs(current_side - side) > 1e-6)
+            double current_side = vertices[i]->distanceTo(*vertices[(i + 1) % n]);
+            if (std::abs(current_side - side) > eps)
                 return false;
         }
 
         for (int i = 0; i < n; ++i) {
             Point<T> v1 = *vertices[(i + 1) % n] - *vertices[i];
             Point<T> v2 = *vertices[(i + 2) % n] - *vertices[(i + 1) % n];
-            if (std::abs(v1.dot(v2)) > 1e-6)
+            if (std::abs(v1.dot(v2)) > this->tolerance(side))
                 return false;
         }
 
@@ -47,24 +47,41 @@ public:
         if (is.rdbuf() == std::cin.rdbuf())
             std::cout << "Enter 4 trapezoid vertices separated by spaces (in x y format):\n";
 
-        for (auto& v : vertices) is >> *v;
+        readVertices(is);
         if (!validate()) throw std::invalid_argument("The entered points do not form a trapezoid!");
     }
 
+    void readVertices(std::istream& is) override {
+        for (auto& v : vertices) is >> *v;
+    }
+
     Point<T> center() const override {
-        T cx = 0, cy = 0;
+        double cx = 0, cy = 0;
         for (const auto& v : vertices) {
             cx += v->x;
             cy += v->y;
         }
-        return Point<T>{cx / 4, cy / 4};
+        return Point<T>{static_cast<T>(cx / 4), static_cast<T>(cy / 4)};
     }
 
     double surface() const override {
-        T a = vertices[0]->distanceTo(*vertices[1]);
-        T b = vertices[2]->distanceTo(*vertices[3]);
-        T h = std::abs(vertices[0]->y - vertices[2]->y);
-        return static_cast<double>((a + b) * h / 2.0);
+        double a = vertices[0]->distanceTo(*vertices[1]);
+        double b = vertices[2]->distanceTo(*vertices[3]);
+        double h = std::abs(double(vertices[0]->y) - double(vertices[2]->y));
+        return (a + b) * h / 2.0;
+    }
+
+    size_t vertexCount() const override {
+        return n;
+    }
+
+    Point<T> vertex(size_t i) const override {
+        if (i >= std::size(vertices)) throw std::out_of_range("Vertex index out of range");
+        return *vertices[i];
+    }
+
+    Footprint footprint() const override {
+        return Footprint{sizeof(*this), n * sizeof(Point<T>), size_t(n)};
     }
 
     operator double() const override {
@@ -105,7 +122,7 @@ public:
 
         double side1 = vertices[1]->distanceTo(*vertices[2]);
         double side2 = vertices[0]->distanceTo(*vertices[3]);
-        return std::abs(side1 - side2) < 1e-6;
+        return std::abs(side1 - side2) < this->tolerance();
     }
 
     ~Trapezoid() override = default;
@@ -6,6 +6,7 @@
 #include "include/Trapezoid.h"
 #include "include/Square.h"
 #include "include/Rectangle.h"
+#include "include/BatchDriver.h"
 
 template <typename T>
 std::string typeName(const Figure<T>& f) {
@@ -15,7 +16,16 @@ std::string typeName(const Figure<T>& f) {
     return "What have you done?";
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // Batch-режим: homework4 --batch [--count N] [--repeat R] [--seed S] [--ops a,b,...]
+    //              homework4 --script FILE|-
+    try {
+        if (BatchDriver::runFromArgs(argc, argv, std::cout)) return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Batch error: " << e.what() << "\n";
+        return 1;
+    }
+
     std::cout << std::fixed << std::setprecision(2);
 
     // ===================================================================
@@ -28,12 +38,16 @@ int main() {
     figures.add(std::make_shared<Square<double>>());
     figures.add(std::make_shared<Rectangle<double>>());
 
+    // Чтение идёт через константную ссылку: неконстантный operator[] выдаёт
+    // изменяемую ссылку и заставляет следующий снимок копировать чанк.
+    const auto& view = figures;
+
     // 3. Ввод вершин для каждой фигуры
     std::cout << "\n=== Input of vertex coordinates ===\n";
     for (size_t i = 0; i < figures.getSize(); ++i) {
         std::cout << "\nFigure " << i << " - " 
-                    << typeName(*figures[i]) << ":\n";
-        std::cin >> *figures[i];
+                    << typeName(*view[i]) << ":\n";
+        std::cin >> *view[i];
     }
 
     // 4. Вывод всех фигур и их площадей
@@ -50,13 +64,13 @@ int main() {
 
     // 7. Проверка operator== и приведения к double
     std::cout << "\n=== Operator checks ===\n";
-    if (figures[0] == figures[1])
+    if (view[0] == view[1])
         std::cout << "Figure 0 is equal to figure 1\n";
     else
         std::cout << "Figure 0 is not equal to figure 1\n";
 
     std::cout << "surface of figure 0 = " 
-                << double(*figures[0]) << std::endl;
+                << double(*view[0]) << std::endl;
 
     // 8. Проверка копирования и перемещения
     std::cout << "\n=== Copy and move semantics test (Trapezoid) ===\n";
@@ -79,7 +93,7 @@ int main() {
     std::cout << "\n=== Testing array index out of bounds ===\n";
     std::cout << "Trying to access figure 10...\n";
     try {
-        std::cout << figures[10];
+        std::cout << view[10];
     } catch (const std::out_of_range& e) {
         std::cerr << "Out of range: " << e.what() << "\n";
     } catch (const std::exception& e) {
@@ -97,6 +111,7 @@ int main() {
     squares.add(Square<double>());
     squares.add(Square<double>());
     squares.add(Square<double>());
+    const auto& squaresView = squares;
 
     // 13. Ввод вершин для каждой фигуры
     std::cout << "\nInput coordinates for 3 squares:\n";
@@ -108,27 +123,27 @@ int main() {
     // 14. Вывод всех фигур и их площадей
     std::cout << "\nSquares and their surfaces:\n";
     for (size_t i = 0; i < squares.getSize(); ++i) {
-        std::cout << i << ": " << squares[i] 
-                    << " | Surface = " << double(squares[i]) << "\n";
+        std::cout << i << ": " << squaresView[i] 
+                    << " | Surface = " << double(squaresView[i]) << "\n";
     }
 
     // 15. Вывод центров фигур
     std::cout << "\nGeometric centers of squares:\n";
     for (size_t i = 0; i < squares.getSize(); ++i) {
-        auto c = squares[i].center();
+        auto c = squaresView[i].center();
         std::cout << i << ": Center = (" << c.x << ", " << c.y << ")\n";
     }
 
     // 16. Общая площадь
     double totalSquareSurface = 0.0;
     for (size_t i = 0; i < squares.getSize(); ++i) {
-        totalSquareSurface += double(squares[i]);
+        totalSquareSurface += double(squaresView[i]);
     }
     std::cout << "\nTotal surface of all squares = " << totalSquareSurface << "\n";
 
     // 17. Проверка operator== и приведения к double
     std::cout << "\nEquality check (squares 0 and 1):\n";
-    if (squares[0] == squares[1])
+    if (squaresView[0] == squaresView[1])
         std::cout << "Square 0 == Square 1\n";
     else
         std::cout << "Square 0 != Square 1\n";
@@ -150,14 +165,14 @@ int main() {
     squares.remove(1);
     std::cout << "Squares after removal:\n";
     for (size_t i = 0; i < squares.getSize(); ++i) {
-        std::cout << i << ": " << squares[i] 
-                    << " | Surface = " << double(squares[i]) << "\n";
+        std::cout << i << ": " << squaresView[i] 
+                    << " | Surface = " << double(squaresView[i]) << "\n";
     }
 
     // 20. Проверка обработки исключения
     std::cout << "Trying to access figure 10...\n";
     try {
-        std::cout << squares[10];
+        std::cout << squaresView[10];
     } catch (const std::out_of_range& e) {
         std::cerr << "Out of range: " << e.what() << "\n";
     }
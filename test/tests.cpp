@@ -1,13 +1,55 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <memory>
 #include <sstream>
 #include <typeinfo>
+#include <thread>
+#include <vector>
+#include <random>
+#include <typeindex>
 
 #include "../include/Figure.h"
 #include "../include/Trapezoid.h"
 #include "../include/Square.h"
 #include "../include/Rectangle.h"
 #include "../include/Array.h"
+#include "../include/PackedFigures.h"
+#include "../include/Rasterizer.h"
+#include "../include/BatchDriver.h"
+#include "../include/OverlapGraph.h"
+#include "../include/ShardedFigures.h"
+#include "../include/CenterClustering.h"
+
+// --- HEAP ACCOUNTING ---
+// Глобальный operator new с заголовком размера: MemoryTest сверяет отчёт Array
+// с тем, сколько байт реально занято в куче.
+namespace {
+constexpr size_t HeapHeader = 16;
+std::atomic<size_t> heapLiveBytes{0};
+}
+
+void* operator new(size_t n) {
+    void* raw = std::malloc(n + HeapHeader);
+    if (!raw) throw std::bad_alloc();
+    *static_cast<size_t*>(raw) = n;
+    heapLiveBytes += n;
+    return static_cast<char*>(raw) + HeapHeader;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    void* raw = static_cast<char*>(p) - HeapHeader;
+    heapLiveBytes -= *static_cast<size_t*>(raw);
+    std::free(raw);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
 
 template <typename T>
 void inputFigure(Figure<T>& fig, const std::string& input) {
@@ -153,8 +195,926 @@ TEST(FigureTest, AbstractClass) {
     EXPECT_TRUE(std::is_abstract_v<Figure<double>>);
 }
 
+// --- SNAPSHOT TESTS ---
+TEST(SnapshotTest, IsolatedFromLaterChanges) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    auto s = std::make_shared<Square<double>>();
+    inputFigure(*s, "0 0  2 0  2 2  0 2");
+    arr.add(s);
+
+    auto snap = arr.snapshot();
+    auto r = std::make_shared<Rectangle<double>>();
+    inputFigure(*r, "0 0  4 0  4 2  0 2");
+    arr.add(r);
+    arr.remove(0);
+
+    EXPECT_EQ(snap.getSize(), 1);
+    EXPECT_DOUBLE_EQ(snap.totalSurface(), 4.0);
+    EXPECT_DOUBLE_EQ(arr.totalSurface(), 8.0);
+    EXPECT_LT(snap.getVersion(), arr.getVersion());
+}
+
+TEST(SnapshotTest, CopyOnWriteAcrossChunks) {
+    Array<int> arr;
+    for (int i = 0; i < 1000; ++i) arr.add(i);
+
+    auto snap = arr.snapshot();
+    Array<int> copy = arr;
+    arr[999] = -1;
+    copy[0] = -2;
+    for (int i = 0; i < 100; ++i) arr.add(i);
+
+    EXPECT_EQ(snap.getSize(), 1000);
+    EXPECT_EQ(snap[0], 0);
+    EXPECT_EQ(snap[999], 999);
+    EXPECT_EQ(copy[999], 999);
+    EXPECT_EQ(arr[0], 0);
+    EXPECT_EQ(arr[999], -1);
+    EXPECT_EQ(copy[0], -2);
+    EXPECT_EQ(arr.getSize(), 1100);
+}
+
+TEST(SnapshotTest, ConstReadsKeepSnapshotsFree) {
+    AllocationCounts counts;
+    Array<int, CountingAllocator<int>> arr{CountingAllocator<int>(&counts)};
+    for (int i = 0; i < 1000; ++i) arr.add(i);
+
+    const auto& view = arr;
+    long sum = 0;
+    for (size_t i = 0; i < view.getSize(); ++i) sum += view[i];
+    size_t before = counts.allocations.load();
+    { auto snap = arr.snapshot(); }
+    EXPECT_EQ(counts.allocations.load(), before);
+    EXPECT_EQ(sum, 999 * 1000 / 2);
+
+    // Неконстантный operator[] помечает чанк: снимок копирует таблицу и этот чанк.
+    sum += arr[0];
+    { auto snap = arr.snapshot(); }
+    EXPECT_EQ(counts.allocations.load(), before + 2);
+}
+
+TEST(SnapshotTest, ReferenceTakenBeforeSnapshotDoesNotLeakIntoIt) {
+    Array<int> arr;
+    for (int i = 0; i < 200; ++i) arr.add(0);
+
+    int& r = arr[0];
+    size_t version = arr.getVersion();
+    auto snap = arr.snapshot();
+    Array<int> copy = arr;
+    r = 5;
+
+    EXPECT_EQ(snap[0], 0);
+    EXPECT_EQ(copy[0], 0);
+    EXPECT_EQ(arr[0], 5);
+    EXPECT_EQ(snap[199], 0);
+    EXPECT_EQ(arr.getVersion(), version);
+}
+
+TEST(SnapshotTest, ConcurrentReadersSeeConsistentState) {
+    Array<long> arr;
+    for (long i = 0; i < 5000; ++i) arr.add(1L);
+
+    std::vector<ArraySnapshot<long>> snaps;
+    std::vector<std::thread> readers;
+    std::vector<long> sums(4, 0);
+    for (int r = 0; r < 4; ++r) snaps.push_back(arr.snapshot());
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&, r] {
+            for (int pass = 0; pass < 20; ++pass) {
+                long sum = 0;
+                for (size_t i = 0; i < snaps[r].getSize(); ++i) sum += snaps[r][i];
+                sums[r] = sum;
+            }
+        });
+    }
+    for (size_t i = 0; i < arr.getSize(); ++i) arr[i] = 2;
+    for (int i = 0; i < 1000; ++i) arr.remove(0);
+    for (auto& t : readers) t.join();
+
+    for (long sum : sums) EXPECT_EQ(sum, 5000);
+    EXPECT_EQ(arr.getSize(), 4000);
+    EXPECT_EQ(arr[0], 2);
+}
+
+// --- STATS TESTS ---
+static std::shared_ptr<Figure<double>> makeFigure(int kind, double x, double y, double k) {
+    std::ostringstream oss;
+    std::shared_ptr<Figure<double>> fig;
+    if (kind == 0) {
+        fig = std::make_shared<Square<double>>();
+        oss << x << " " << y << " " << x + k << " " << y << " " << x + k << " " << y + k << " " << x << " " << y + k;
+    } else if (kind == 1) {
+        fig = std::make_shared<Rectangle<double>>();
+        oss << x << " " << y << " " << x + 2 * k << " " << y << " " << x + 2 * k << " " << y + k << " " << x << " " << y + k;
+    } else {
+        fig = std::make_shared<Trapezoid<double>>();
+        oss << x << " " << y << " " << x + 3 * k << " " << y << " " << x + 2 * k << " " << y + k << " " << x + k << " " << y + k;
+    }
+    inputFigure(*fig, oss.str());
+    return fig;
+}
+
+static void expectStatsMatchRecompute(const Array<std::shared_ptr<Figure<double>>>& arr) {
+    const ArrayStats& st = arr.getStats();
+    double total = 0, cx = 0, cy = 0;
+    double lo = 1e300, hi = -1e300;
+    size_t squares = 0;
+    for (size_t i = 0; i < arr.getSize(); ++i) {
+        double s = arr[i]->surface();
+        total += s;
+        lo = std::min(lo, s);
+        hi = std::max(hi, s);
+        cx += arr[i]->center().x;
+        cy += arr[i]->center().y;
+        if (dynamic_cast<const Square<double>*>(arr[i].get())) ++squares;
+    }
+    ASSERT_EQ(st.count(), arr.getSize());
+    EXPECT_NEAR(st.totalSurface(), total, 1e-9 * (1 + total));
+    EXPECT_EQ(st.countOf<Square<double>>(), squares);
+    if (arr.getSize() == 0) return;
+    EXPECT_DOUBLE_EQ(st.minSurface(), lo);
+    EXPECT_DOUBLE_EQ(st.maxSurface(), hi);
+    EXPECT_NEAR(st.centroid().x, cx / arr.getSize(), 1e-9);
+    EXPECT_NEAR(st.centroid().y, cy / arr.getSize(), 1e-9);
+}
+
+TEST(StatsTest, NotTrackedByDefault) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    EXPECT_FALSE(arr.hasStats());
+    EXPECT_THROW(arr.getStats(), std::logic_error);
+}
+
+TEST(StatsTest, MatchFullRecomputation) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.add(makeFigure(0, 0, 0, 2));
+    arr.trackStats();
+    expectStatsMatchRecompute(arr);
+
+    std::mt19937 rng(42);
+    for (int step = 0; step < 2000; ++step) {
+        int op = rng() % 4;
+        auto fig = makeFigure(rng() % 3, rng() % 100, rng() % 100, 1 + rng() % 9);
+        if (op == 0 && arr.getSize() > 0) arr.remove(rng() % arr.getSize());
+        else if (op == 1 && arr.getSize() > 0) arr.set(rng() % arr.getSize(), fig);
+        else arr.add(fig);
+    }
+    expectStatsMatchRecompute(arr);
+    EXPECT_EQ(arr.getStats().countOf<Square<double>>() + arr.getStats().countOf<Rectangle<double>>()
+              + arr.getStats().countOf<Trapezoid<double>>(), arr.getSize());
+}
+
+TEST(StatsTest, NoDriftAfterLongChurn) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.trackStats();
+    arr.add(makeFigure(0, 0, 0, 1));
+    double naive = 1.0;
+    for (int i = 0; i < 1000; ++i) {
+        arr.add(makeFigure(0, 0, 0, 1e8));
+        arr.remove(1);
+        naive += 1e16;
+        naive -= 1e16;
+    }
+    EXPECT_NE(naive, 1.0);
+    EXPECT_EQ(arr.getStats().totalSurface(), 1.0);
+    EXPECT_EQ(arr.totalSurface(), 1.0);
+    EXPECT_EQ(arr.getStats().centroid().x, 0.5);
+    EXPECT_EQ(arr.getStats().maxSurface(), 1.0);
+}
+
+TEST(StatsTest, RemoveAfterInPlaceEditSubtractsStoredContribution) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.trackStats();
+    arr.add(makeFigure(0, 0, 0, 1));
+    inputFigure(*arr[0], "0 0 3 0 3 3 0 3");
+    arr.remove(0);
+
+    const ArrayStats& st = arr.getStats();
+    EXPECT_EQ(st.count(), 0);
+    EXPECT_EQ(st.totalSurface(), 0.0);
+    EXPECT_EQ(st.minSurface(), 0.0);
+    EXPECT_EQ(st.countOf<Square<double>>(), 0);
+
+    arr.add(makeFigure(1, 0, 0, 1));
+    arr.add(nullptr);
+    arr.set(1, makeFigure(0, 0, 0, 2));
+    arr.remove(0);
+    EXPECT_EQ(st.count(), 1);
+    EXPECT_EQ(st.totalSurface(), 4.0);
+}
+
+TEST(StatsTest, SnapshotsUnderChurnKeepTheirAggregates) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    std::mt19937 rng(17);
+    for (int i = 0; i < 300; ++i) arr.add(makeFigure(rng() % 3, rng() % 100, rng() % 100, 1 + rng() % 9));
+    arr.trackStats();
+
+    struct Seen {
+        double total, lo, hi;
+        size_t count;
+    };
+    std::vector<ArraySnapshot<std::shared_ptr<Figure<double>>>> snaps;
+    std::vector<Seen> seen;
+    for (int step = 0; step < 400; ++step) {
+        snaps.push_back(arr.snapshot());
+        const ArrayStats& st = snaps.back().getStats();
+        seen.push_back(Seen{st.totalSurface(), st.minSurface(), st.maxSurface(), st.count()});
+        int op = rng() % 3;
+        auto fig = makeFigure(rng() % 3, rng() % 100, rng() % 100, 1 + rng() % 20);
+        if (op == 0) arr.remove(rng() % arr.getSize());
+        else if (op == 1) arr.set(rng() % arr.getSize(), fig);
+        else arr.add(fig);
+    }
+    expectStatsMatchRecompute(arr);
+    for (size_t i = 0; i < snaps.size(); ++i) {
+        const ArrayStats& st = snaps[i].getStats();
+        EXPECT_EQ(st.totalSurface(), seen[i].total);
+        EXPECT_EQ(st.minSurface(), seen[i].lo);
+        EXPECT_EQ(st.maxSurface(), seen[i].hi);
+        EXPECT_EQ(st.count(), seen[i].count);
+    }
+}
+
+TEST(StatsTest, SnapshotKeepsItsAggregates) {
+    Array<Square<double>> arr;
+    Square<double> s;
+    inputFigure(s, "0 0  2 0  2 2  0 2");
+    arr.add(s);
+    arr.trackStats();
+
+    auto snap = arr.snapshot();
+    arr.add(s);
+    EXPECT_DOUBLE_EQ(snap.getStats().totalSurface(), 4.0);
+    EXPECT_DOUBLE_EQ(arr.getStats().totalSurface(), 8.0);
+    EXPECT_EQ(arr.getStats().countOf<Square<double>>(), 2);
+}
+
+// --- MIXED PRECISION TESTS ---
+TEST(MixedPrecisionTest, FloatStorageMatchesDoubleOnExactInput) {
+    Trapezoid<float> tf;
+    Trapezoid<double> td;
+    inputFigure(tf, "0 0  6 0  4 4  2 4");
+    inputFigure(td, "0 0  6 0  4 4  2 4");
+    EXPECT_DOUBLE_EQ(tf.surface(), td.surface());
+    EXPECT_FLOAT_EQ(tf.center().x, 3.0f);
+    EXPECT_FLOAT_EQ(tf.center().y, 2.0f);
+    EXPECT_EQ(sizeof(Point<float>) * 2, sizeof(Point<double>));
+}
+
+TEST(MixedPrecisionTest, TotalsCloseToDoublePath) {
+    Array<std::shared_ptr<Figure<float>>> floats;
+    Array<std::shared_ptr<Figure<double>>> doubles;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> side(0.01f, 50.0f);
+    for (int i = 0; i < 5000; ++i) {
+        float x = coord(rng), y = coord(rng), w = side(rng), h = side(rng);
+        std::ostringstream oss;
+        oss.precision(9);
+        oss << x << " " << y << " " << x + w << " " << y << " "
+            << x + w << " " << y + h << " " << x << " " << y + h;
+        auto rf = std::make_shared<Rectangle<float>>();
+        auto rd = std::make_shared<Rectangle<double>>();
+        std::istringstream inf(oss.str()), ind(oss.str());
+        try {
+            inf >> *rf;
+            ind >> *rd;
+        } catch (const std::invalid_argument&) {
+            continue;
+        }
+        floats.add(rf);
+        doubles.add(rd);
+    }
+    ASSERT_GT(floats.getSize(), 1000);
+    double expected = doubles.totalSurface();
+    EXPECT_NEAR(floats.totalSurface(), expected, expected * 1e-6);
+}
+
+TEST(MixedPrecisionTest, CompensatedTotalDoesNotDrift) {
+    Array<Square<float>> squares;
+    Square<float> big, small;
+    inputFigure(big, "0 0  1e8 0  1e8 1e8  0 1e8");
+    inputFigure(small, "0 0  0.5 0  0.5 0.5  0 0.5");
+    squares.add(big);
+    for (int i = 0; i < 4000; ++i) squares.add(small);
+
+    double naive = 0;
+    for (size_t i = 0; i < squares.getSize(); ++i) naive += squares[i].surface();
+    double expected = 1e16 + 1000.0;
+    EXPECT_NE(naive, expected);
+    EXPECT_EQ(squares.totalSurface(), expected);
+    EXPECT_EQ(PackedFigures<float>::from(squares).totalSurface(), expected);
+}
+
+TEST(MixedPrecisionTest, PackedFloatMatchesFloatFigures) {
+    Array<std::shared_ptr<Figure<float>>> figures;
+    std::mt19937 rng(11);
+    for (int i = 0; i < 300; ++i) {
+        std::ostringstream oss;
+        int x = rng() % 1000, y = rng() % 1000, k = 1 + rng() % 20;
+        std::shared_ptr<Figure<float>> fig;
+        if (i % 3 == 0) {
+            fig = std::make_shared<Square<float>>();
+            oss << x << " " << y << " " << x + k << " " << y << " " << x + k << " " << y + k << " " << x << " " << y + k;
+        } else if (i % 3 == 1) {
+            fig = std::make_shared<Rectangle<float>>();
+            oss << x << " " << y << " " << x + 2 * k << " " << y << " " << x + 2 * k << " " << y + k << " " << x << " " << y + k;
+        } else {
+            fig = std::make_shared<Trapezoid<float>>();
+            oss << x << " " << y << " " << x + 3 * k << " " << y << " " << x + 2 * k << " " << y + k << " " << x + k << " " << y + k;
+        }
+        inputFigure(*fig, oss.str());
+        figures.add(fig);
+        if (i % 50 == 0) figures.add(nullptr);
+    }
+
+    auto packed = PackedFigures<float>::from(figures);
+    ASSERT_EQ(packed.getSize(), 300);
+    for (size_t i = 0; i < packed.getSize(); ++i) {
+        const Figure<float>& fig = *figures[packed.index[i]];
+        EXPECT_EQ(packed.surface(i), fig.surface());
+        EXPECT_FLOAT_EQ(float(packed.center(i).x), fig.center().x);
+        EXPECT_EQ(packed.vertex(i, 2), fig.vertex(2));
+    }
+    EXPECT_EQ(packed.kind(2), PackedKind::Trapezoid);
+    EXPECT_EQ(packed.index[1], 2);
+    EXPECT_EQ(packed.totalSurface(), figures.totalSurface());
+    EXPECT_EQ(sizeof(PackedQuad<float>) * 2, sizeof(PackedQuad<double>));
+}
+
+// --- RASTERIZER TESTS ---
+TEST(FigureTest, VerticesAndContains) {
+    Trapezoid<double> t;
+    inputFigure(t, "0 0  6 0  4 4  2 4");
+    EXPECT_EQ(t.vertexCount(), 4);
+    EXPECT_EQ(t.vertex(2), Point<double>(4, 4));
+    EXPECT_THROW(t.vertex(4), std::out_of_range);
+    EXPECT_TRUE(t.contains({3, 2}));
+    EXPECT_TRUE(t.contains({0.5, 0.1}));
+    EXPECT_FALSE(t.contains({0.5, 3.9}));
+    EXPECT_FALSE(t.contains({7, 1}));
+}
+
+TEST(RasterizerTest, CountsAlignedFigures) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    auto s = std::make_shared<Square<double>>();
+    inputFigure(*s, "0 0  4 0  4 4  0 4");
+    arr.add(s);
+    auto r = std::make_shared<Rectangle<double>>();
+    inputFigure(*r, "2 2  8 2  8 3  2 3");
+    arr.add(r);
+
+    RasterGrid grid{0, 0, 1, 10, 5};
+    std::vector<uint32_t> counts(grid.width * grid.height);
+    Rasterizer(grid, 3, 4).coverageCounts(arr, counts);
+
+    EXPECT_EQ(counts[0 * 10 + 0], 1u);
+    EXPECT_EQ(counts[2 * 10 + 3], 2u);
+    EXPECT_EQ(counts[2 * 10 + 7], 1u);
+    EXPECT_EQ(counts[2 * 10 + 8], 0u);
+    EXPECT_EQ(counts[4 * 10 + 0], 0u);
+    uint32_t total = 0;
+    for (auto c : counts) total += c;
+    EXPECT_EQ(total, 16u + 6u);
+}
+
+TEST(RasterizerTest, CountsMatchContainsOnRandomFigures) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    std::mt19937 rng(3);
+    for (int i = 0; i < 300; ++i)
+        arr.add(makeFigure(rng() % 3, (rng() % 4000) / 100.0 - 5, (rng() % 4000) / 100.0 - 5, 0.3 + (rng() % 500) / 100.0));
+
+    RasterGrid grid{-2.5, -1.25, 0.37, 120, 110};
+    std::vector<uint32_t> counts(grid.width * grid.height);
+    Rasterizer(grid, 4, 16).coverageCounts(arr, counts);
+
+    for (size_t row = 0; row < grid.height; row += 3)
+        for (size_t col = 0; col < grid.width; col += 3) {
+            Point<double> p(grid.originX + (col + 0.5) * grid.cellSize, grid.originY + (row + 0.5) * grid.cellSize);
+            uint32_t expected = 0;
+            for (size_t i = 0; i < arr.getSize(); ++i) expected += arr[i]->contains(p);
+            ASSERT_EQ(counts[row * grid.width + col], expected) << col << "," << row;
+        }
+}
+
+TEST(RasterizerTest, FractionIsUnionAndThreadIndependent) {
+    Array<Square<double>> arr;
+    Square<double> a, b;
+    inputFigure(a, "0 0  1.5 0  1.5 1.5  0 1.5");
+    inputFigure(b, "0 0  1 0  1 1  0 1");
+    arr.add(a);
+    arr.add(b);
+
+    RasterGrid grid{0, 0, 1, 3, 3};
+    std::vector<float> one(9), many(9);
+    Rasterizer(grid, 1, 2).coverageFraction(arr, one, 4);
+    Rasterizer(grid, 4, 1).coverageFraction(arr, many, 4);
+
+    EXPECT_FLOAT_EQ(one[0], 1.0f);
+    EXPECT_FLOAT_EQ(one[1], 0.5f);
+    EXPECT_FLOAT_EQ(one[4], 0.25f);
+    EXPECT_FLOAT_EQ(one[2], 0.0f);
+    EXPECT_EQ(one, many);
+
+    std::vector<float> wrong(8);
+    EXPECT_THROW(Rasterizer(grid).coverageFraction(arr, wrong), std::invalid_argument);
+}
+
+// --- BATCH DRIVER TESTS ---
+TEST(BatchDriverTest, ScriptRunsAllPhases) {
+    std::ostringstream out;
+    BatchDriver driver(out);
+    std::istringstream script(
+        "# comment\n"
+        "seed 5\n"
+        "generate 50\n"
+        "add\n"
+        "total 3\n"
+        "centers\n"
+        "equality 2\n"
+        "copy\n"
+        "memory\n"
+        "remove 30\n");
+    driver.runScript(script);
+
+    EXPECT_EQ(driver.getFigures().getSize(), 120);
+    std::istringstream lines(out.str());
+    std::vector<std::string> phases;
+    for (std::string line; std::getline(lines, line);) {
+        EXPECT_NE(line.find("\"seconds\":"), std::string::npos);
+        EXPECT_NE(line.find("\"peak_rss_kb\":"), std::string::npos);
+        phases.push_back(line.substr(10, line.find('"', 10) - 10));
+    }
+    EXPECT_EQ(phases, (std::vector<std::string>{"seed", "generate", "add", "total", "centers",
+                                                "equality", "copy", "memory", "remove"}));
+    EXPECT_NE(out.str().find("{\"phase\":\"add\",\"items\":150,"), std::string::npos);
+}
+
+TEST(BatchDriverTest, ArgsSelectMode) {
+    std::ostringstream out;
+    char prog[] = "homework4";
+    char* none[] = {prog};
+    EXPECT_FALSE(BatchDriver::runFromArgs(1, none, out));
+    EXPECT_TRUE(out.str().empty());
+
+    char batch[] = "--batch", count[] = "--count", n[] = "10", ops[] = "--ops", list[] = "add,total";
+    char* args[] = {prog, batch, count, n, ops, list};
+    EXPECT_TRUE(BatchDriver::runFromArgs(6, args, out));
+    EXPECT_NE(out.str().find("\"phase\":\"total\",\"items\":30,"), std::string::npos);
+
+    std::istringstream bad("explode\n");
+    BatchDriver driver(out);
+    EXPECT_THROW(driver.runScript(bad), std::invalid_argument);
+}
+
+// --- NON-THROWING API TESTS ---
+TEST(TryReadTest, ReportsReason) {
+    Square<double> s;
+    std::istringstream ok("0 0  2 0  2 2  0 2"), dup("1 1  1 1  2 2  0 2"),
+        shape("0 0  3 0  4 3  1 3"), broken("0 0  2 x");
+    EXPECT_EQ(s.tryRead(ok), FigureError::None);
+    EXPECT_DOUBLE_EQ(s.surface(), 4.0);
+    EXPECT_EQ(s.tryRead(dup), FigureError::DuplicateVertices);
+    EXPECT_EQ(s.tryRead(shape), FigureError::InvalidShape);
+    EXPECT_EQ(s.tryRead(broken), FigureError::InputFailed);
+    EXPECT_STREQ(describe(FigureError::InvalidShape), "points do not form the figure");
+}
+
+TEST(TryReadTest, FloatToleranceScalesWithCoordinates) {
+    // Повёрнутый единичный квадрат вдали от нуля: округление до float
+    // искажает стороны на ~1e-5, что больше прежнего абсолютного допуска.
+    const char* rotated = "100.3 100.2  100.9 101.0  100.1 101.6  99.5 100.8";
+    const char* trapezoid = "1000.1 1000.3  1004.2 1000.3  1003.1 1002.7  1001.2 1002.7";
+    Square<float> sf;
+    Rectangle<float> rf;
+    Trapezoid<float> tf;
+    std::istringstream s1(rotated), s2(rotated), s3(trapezoid);
+    EXPECT_EQ(sf.tryRead(s1), FigureError::None);
+    EXPECT_NEAR(sf.surface(), 1.0, 1e-4);
+    EXPECT_EQ(rf.tryRead(s2), FigureError::None);
+    EXPECT_EQ(tf.tryRead(s3), FigureError::None);
+
+    // Допуск остаётся относительным: заметно кривая фигура по-прежнему отвергается.
+    std::istringstream skewed("100.3 100.2  100.9 101.0  100.1 101.6  99.5 100.9");
+    EXPECT_EQ(sf.tryRead(skewed), FigureError::InvalidShape);
+}
+
+TEST(TryAddTest, RejectsWithoutThrowing) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    auto good = std::make_shared<Rectangle<double>>();
+    inputFigure(*good, "0 0  4 0  4 2  0 2");
+    auto bad = std::make_shared<Trapezoid<double>>();
+    std::istringstream iss("0 0  4 0  3 3  0 3");
+    EXPECT_EQ(bad->tryRead(iss), FigureError::InvalidShape);
+
+    EXPECT_EQ(arr.tryAdd(good), FigureError::None);
+    EXPECT_EQ(arr.tryAdd(bad), FigureError::InvalidShape);
+    EXPECT_EQ(arr.tryAdd(std::shared_ptr<Figure<double>>()), FigureError::Empty);
+    EXPECT_EQ(arr.getSize(), 1);
+}
+
+TEST(UncheckedTest, MatchesCheckedAccess) {
+    Array<int> arr;
+    for (int i = 0; i < 300; ++i) arr.add(i);
+    const auto& view = arr;
+    long sum = 0;
+    view.forEach([&](int v) { sum += v; });
+    EXPECT_EQ(sum, 299 * 300 / 2);
+    for (size_t i = 0; i < arr.getSize(); i += 37) EXPECT_EQ(view.unchecked(i), view[i]);
+
+    auto snap = arr.snapshot();
+    arr.unchecked(5) = -5;
+    EXPECT_EQ(arr[5], -5);
+    EXPECT_EQ(snap[5], 5);
+}
+
+TEST(UncheckedTest, MutableReferenceStaysOutOfLaterSnapshots) {
+    Array<int> arr;
+    for (int i = 0; i < 300; ++i) arr.add(i);
+    size_t version = arr.getVersion();
+    int& first = arr.unchecked(70);
+    int& second = arr.unchecked(71);
+    auto snap = arr.snapshot();
+    first = -1;
+    second = -2;
+    EXPECT_EQ(snap[70], 70);
+    EXPECT_EQ(snap[71], 71);
+    EXPECT_EQ(arr[70], -1);
+    EXPECT_EQ(arr.getVersion(), version);
+}
+
+// --- OVERLAP GRAPH TESTS ---
+TEST(OverlapGraphTest, TouchingAndOverlappingFiguresMerge) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    auto add = [&](auto fig, const std::string& coords) {
+        inputFigure(*fig, coords);
+        arr.add(fig);
+    };
+    add(std::make_shared<Rectangle<double>>(), "0 0  2 0  2 1  0 1");        // 0
+    add(std::make_shared<Rectangle<double>>(), "2 0  4 0  4 1  2 1");        // 1: общая сторона с 0
+    add(std::make_shared<Square<double>>(), "4 1  5 1  5 2  4 2");           // 2: касание углом с 1
+    add(std::make_shared<Square<double>>(), "10 10  11 10  11 11  10 11");   // 3: отдельно
+    add(std::make_shared<Square<double>>(), "9 9  13 9  13 13  9 13");       // 4: содержит 3
+    add(std::make_shared<Trapezoid<double>>(), "20 0  26 0  24 2  22 2");    // 5: отдельно
+    arr.add(std::shared_ptr<Figure<double>>());                               // 6: пустой
+
+    ClusterResult r = OverlapGraph(3).cluster(arr);
+    ASSERT_EQ(r.clusters.size(), 3);
+    EXPECT_EQ(r.clusters[0].members, (std::vector<size_t>{0, 1, 2}));
+    EXPECT_EQ(r.clusters[1].members, (std::vector<size_t>{3, 4}));
+    EXPECT_EQ(r.clusters[2].members, (std::vector<size_t>{5}));
+    EXPECT_DOUBLE_EQ(r.clusters[0].surface, 5.0);
+    EXPECT_DOUBLE_EQ(r.clusters[1].surface, 17.0);
+    EXPECT_DOUBLE_EQ(r.clusters[0].maxX, 5.0);
+    EXPECT_DOUBLE_EQ(r.clusters[0].maxY, 2.0);
+    EXPECT_EQ(r.component[2], 0);
+    EXPECT_EQ(r.component[6], std::numeric_limits<size_t>::max());
+    EXPECT_EQ(r.edges, (std::vector<std::pair<size_t, size_t>>{{0, 1}, {1, 2}, {3, 4}}));
+}
+
+TEST(OverlapGraphTest, ResultDoesNotDependOnThreads) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    std::mt19937 rng(11);
+    for (int i = 0; i < 2000; ++i)
+        arr.add(makeFigure(rng() % 3, rng() % 400, rng() % 400, 1 + rng() % 6));
+
+    ClusterResult one = OverlapGraph(1).cluster(arr);
+    ClusterResult many = OverlapGraph(6).cluster(arr);
+    EXPECT_EQ(one.component, many.component);
+    EXPECT_EQ(one.edges, many.edges);
+    ASSERT_EQ(one.clusters.size(), many.clusters.size());
+    EXPECT_GT(one.clusters.size(), 1);
+    EXPECT_LT(one.clusters.size(), arr.getSize());
+
+    double total = 0;
+    for (const auto& c : many.clusters) total += c.surface;
+    EXPECT_NEAR(total, arr.totalSurface(), 1e-6);
+    for (auto [a, b] : many.edges) EXPECT_EQ(many.component[a], many.component[b]);
+}
+
+// --- SHARDED TESTS ---
+TEST(ShardedTest, FlatFormulasMatchFigures) {
+    for (int kind = 0; kind < 3; ++kind) {
+        auto fig = makeFigure(kind, 1.5, -2.25, 3.75);
+        FlatFigure flat{FlatType(kind), {}, {}};
+        for (size_t v = 0; v < 4; ++v) {
+            flat.x[v] = fig->vertex(v).x;
+            flat.y[v] = fig->vertex(v).y;
+        }
+        EXPECT_NEAR(flatSurface(flat), fig->surface(), 1e-12);
+        EXPECT_DOUBLE_EQ(flatCenter(flat).x, fig->center().x);
+        EXPECT_DOUBLE_EQ(flatCenter(flat).y, fig->center().y);
+    }
+}
+
+TEST(ShardedTest, QueriesMatchSingleProcessArray) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    std::mt19937 rng(21);
+    for (int i = 0; i < 1000; ++i) arr.add(makeFigure(i % 3, rng() % 500, rng() % 500, 1 + rng() % 20));
+
+    ShardedFigures sharded(3);
+    sharded.addAll(arr);
+    ASSERT_EQ(sharded.getSize(), arr.getSize());
+    EXPECT_NEAR(sharded.totalSurface(), arr.totalSurface(), 1e-6);
+
+    auto counts = sharded.typeCounts();
+    EXPECT_EQ(counts[size_t(FlatType::Square)], 334);
+    EXPECT_EQ(counts[size_t(FlatType::Rectangle)], 333);
+    EXPECT_EQ(counts[size_t(FlatType::Trapezoid)], 333);
+
+    auto top = sharded.topK(5);
+    ASSERT_EQ(top.size(), 5);
+    std::vector<double> surfaces;
+    for (size_t i = 0; i < arr.getSize(); ++i) surfaces.push_back(arr[i]->surface());
+    std::sort(surfaces.rbegin(), surfaces.rend());
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_NEAR(top[i].first, surfaces[i], 1e-9);
+        EXPECT_NEAR(arr[top[i].second]->surface(), top[i].first, 1e-9);
+    }
+
+    std::vector<size_t> expected;
+    for (size_t i = 0; i < arr.getSize(); ++i) {
+        auto c = arr[i]->center();
+        if (c.x >= 100 && c.x <= 200 && c.y >= 50 && c.y <= 300) expected.push_back(i);
+    }
+    EXPECT_EQ(sharded.inRegion(100, 50, 200, 300), expected);
+}
+
+TEST(ShardedTest, RemoveRebalancesShards) {
+    ShardedFigures sharded(4);
+    std::vector<size_t> ids;
+    for (int i = 0; i < 400; ++i) ids.push_back(sharded.add(*makeFigure(0, i, 0, 1)));
+    EXPECT_DOUBLE_EQ(sharded.totalSurface(), 400.0);
+
+    // Удаляем только фигуры, попавшие в шард 0 при добавлении по кругу.
+    for (int i = 0; i < 400; i += 4) sharded.remove(ids[i]);
+    EXPECT_EQ(sharded.getSize(), 300);
+    for (size_t s = 0; s < sharded.getShardCount(); ++s) {
+        EXPECT_GE(sharded.shardSize(s), 74);
+        EXPECT_LE(sharded.shardSize(s), 76);
+    }
+    EXPECT_DOUBLE_EQ(sharded.totalSurface(), 300.0);
+    EXPECT_THROW(sharded.remove(ids[0]), std::out_of_range);
+
+    auto inside = sharded.inRegion(0, 0, 8, 1);
+    EXPECT_EQ(inside, (std::vector<size_t>{ids[1], ids[2], ids[3], ids[5], ids[6], ids[7]}));
+}
+
+TEST(ShardedTest, TopKBreaksTiesByIdAcrossShards) {
+    ShardedFigures sharded(3);
+    for (int i = 0; i < 30; ++i) sharded.add(*makeFigure(0, i, 0, i < 20 ? 2 : 1));
+    sharded.remove(0);
+    sharded.remove(4);
+
+    auto top = sharded.topK(5);
+    std::vector<size_t> ids;
+    for (const auto& [surface, id] : top) {
+        EXPECT_EQ(surface, 4.0);
+        ids.push_back(id);
+    }
+    EXPECT_EQ(ids, (std::vector<size_t>{1, 2, 3, 5, 6}));
+}
+
+TEST(ShardedTest, WorkerFailurePoisonsInstance) {
+    ShardedFigures sharded(2);
+    for (int i = 0; i < 10; ++i) sharded.add(*makeFigure(0, i, 0, 1));
+    ASSERT_DOUBLE_EQ(sharded.totalSurface(), 10.0);
+
+    std::ifstream children("/proc/self/task/" + std::to_string(getpid()) + "/children");
+    std::vector<pid_t> workers;
+    for (pid_t pid; children >> pid;) workers.push_back(pid);
+    if (workers.size() != 2) GTEST_SKIP() << "worker pids are not visible";
+
+    kill(workers[1], SIGKILL);
+    EXPECT_THROW(sharded.totalSurface(), std::runtime_error);
+    EXPECT_THROW(sharded.typeCounts(), std::runtime_error);
+    EXPECT_EQ(sharded.getSize(), 10);
+}
+
+// Текущий VmRSS процесса в килобайтах, 0 если /proc недоступен.
+static long residentKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.rfind("VmRSS:", 0) == 0) return std::stol(line.substr(6));
+    return 0;
+}
+
+TEST(ShardedTest, CoordinatorMemoryDoesNotGrowWithData) {
+    ShardedFigures sharded(4);
+    auto fig = makeFigure(1, 0, 0, 2);
+    sharded.add(*fig);
+    ASSERT_DOUBLE_EQ(sharded.totalSurface(), fig->surface());
+    long before = residentKb();
+    if (before == 0) GTEST_SKIP() << "VmRSS is not available";
+
+    // 200000 записей по sizeof(FlatFigure) + 8 байт — около 16 МБ, но все они у воркеров.
+    const size_t n = 200000;
+    for (size_t i = 1; i < n; ++i) sharded.add(*fig);
+    EXPECT_NEAR(sharded.totalSurface(), n * fig->surface(), 1e-6 * n);
+    sharded.remove(n / 2);
+    EXPECT_EQ(sharded.getSize(), n - 1);
+    EXPECT_EQ(sharded.typeCounts()[size_t(FlatType::Rectangle)], n - 1);
+    EXPECT_LT(residentKb() - before, 4096);
+}
+
+TEST(ShardedTest, SegmentNamesAreUnlinkedAfterStartup) {
+    ShardedFigures sharded(2);
+    sharded.add(*makeFigure(0, 0, 0, 1));
+    ASSERT_DOUBLE_EQ(sharded.totalSurface(), 1.0);
+    std::string prefix = "homework4-" + std::to_string(getpid()) + "-";
+    std::ifstream probe("/dev/shm");
+    if (!probe) GTEST_SKIP() << "/dev/shm is not available";
+    for (const auto& entry : std::filesystem::directory_iterator("/dev/shm"))
+        EXPECT_NE(entry.path().filename().string().rfind(prefix, 0), 0u) << entry.path();
+}
+
+// --- CLUSTERING TESTS ---
+static CenterBuffer blobs(size_t perBlob, unsigned seed) {
+    CenterBuffer buffer;
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    const double cx[3] = {0, 100, 0}, cy[3] = {0, 0, 100};
+    for (size_t i = 0; i < perBlob; ++i)
+        for (int b = 0; b < 3; ++b) buffer.add(cx[b] + noise(rng), cy[b] + noise(rng), 1.0 + b);
+    return buffer;
+}
+
+TEST(ClusteringTest, CenterBufferFromArray) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.add(makeFigure(0, 0, 0, 2));
+    arr.add(std::shared_ptr<Figure<double>>());
+    arr.add(makeFigure(1, 10, 10, 1));
+    CenterBuffer buffer = CenterBuffer::from(arr);
+    ASSERT_EQ(buffer.size(), 2);
+    EXPECT_DOUBLE_EQ(buffer.x[0], 1.0);
+    EXPECT_DOUBLE_EQ(buffer.y[1], 10.5);
+    EXPECT_DOUBLE_EQ(buffer.surface[1], 2.0);
+    EXPECT_EQ(buffer.index, (std::vector<size_t>{0, 2}));
+}
+
+TEST(ClusteringTest, KMeansFindsSeparatedBlobs) {
+    CenterBuffer points = blobs(2000, 5);
+    ClusteringResult r = KMeans(3, 4).run(points);
+    EXPECT_TRUE(r.converged);
+    ASSERT_EQ(r.centroids.size(), 3);
+
+    std::vector<double> surfaces = r.surface;
+    std::sort(surfaces.begin(), surfaces.end());
+    EXPECT_DOUBLE_EQ(surfaces[0], 2000.0);
+    EXPECT_DOUBLE_EQ(surfaces[1], 4000.0);
+    EXPECT_DOUBLE_EQ(surfaces[2], 6000.0);
+    for (size_t c = 0; c < 3; ++c) {
+        EXPECT_EQ(r.sizes[c], 2000);
+        double fromOrigin = std::min({std::hypot(r.centroids[c].x, r.centroids[c].y),
+                                      std::hypot(r.centroids[c].x - 100, r.centroids[c].y),
+                                      std::hypot(r.centroids[c].x, r.centroids[c].y - 100)});
+        EXPECT_LT(fromOrigin, 0.2);
+    }
+    for (size_t i = 0; i < points.size(); ++i) ASSERT_EQ(r.assignment[i], r.assignment[i % 3]);
+    EXPECT_NE(r.assignment[0], r.assignment[1]);
+
+    ClusteringResult single = KMeans(3, 1).run(points);
+    EXPECT_EQ(single.assignment, r.assignment);
+    EXPECT_NEAR(single.inertia, r.inertia, 1e-6 * r.inertia);
+    EXPECT_THROW(KMeans(10).run(blobs(1, 1)), std::invalid_argument);
+}
+
+TEST(ClusteringTest, GridDensityMarksNoise) {
+    CenterBuffer points = blobs(500, 9);
+    points.add(50, 50, 7.0);
+    ClusteringResult r = GridClustering(5.0, 3).run(points);
+    ASSERT_EQ(r.centroids.size(), 3);
+    EXPECT_EQ(r.assignment.back(), ClusteringResult::Noise);
+    size_t clustered = 0;
+    for (size_t c = 0; c < 3; ++c) clustered += r.sizes[c];
+    EXPECT_GE(clustered, 1490);
+    EXPECT_EQ(r.assignment[0], 0u);
+    EXPECT_EQ(r.assignment[1], 1u);
+    EXPECT_EQ(r.assignment[2], 2u);
+    EXPECT_NEAR(r.centroids[1].x, 100, 0.5);
+}
+
+TEST(ClusteringTest, GridRejectsCoordinatesOutsideCellRange) {
+    CenterBuffer points = blobs(10, 3);
+    EXPECT_NO_THROW(GridClustering(1.0).run(points));
+
+    CenterBuffer far = points;
+    far.add(1e12, 0, 1.0);
+    EXPECT_THROW(GridClustering(1.0).run(far), std::invalid_argument);
+    EXPECT_EQ(GridClustering(1e4).run(far).centroids.size(), 2);
+
+    CenterBuffer nan = points;
+    nan.add(std::nan(""), 0, 1.0);
+    EXPECT_THROW(GridClustering(1.0).run(nan), std::invalid_argument);
+}
+
+// --- MEMORY TESTS ---
+TEST(MemoryTest, ReportBreaksDownFootprint) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    auto sq = makeFigure(0, 0, 0, 1);
+    arr.add(sq);
+    arr.add(sq);
+    arr.add(makeFigure(2, 0, 0, 1));
+
+    MemoryReport r = arr.memoryReport();
+    using Ptr = std::shared_ptr<Figure<double>>;
+    EXPECT_EQ(r.elementBytes, 3 * sizeof(Ptr));
+    EXPECT_EQ(r.slackBytes, (Array<Ptr>::ChunkSize - 3) * sizeof(Ptr) + 3 * sizeof(std::shared_ptr<Ptr[]>));
+    EXPECT_EQ(r.figureHeapBytes, sizeof(Square<double>) + sizeof(Trapezoid<double>) + 8 * sizeof(Point<double>));
+    using Chunk = std::shared_ptr<Ptr[]>;
+    EXPECT_EQ(r.tableBytes, sizeof(Chunk));
+    EXPECT_EQ(r.controlBlockBytes, sharedArrayControlBytes<Ptr>(std::allocator<Ptr>())
+                                   + sharedArrayControlBytes<Chunk>(std::allocator<Chunk>()) + 2 * ControlBlockBytes);
+    EXPECT_GT(r.allocatorOverheadBytes, 0);
+    EXPECT_EQ(r.total(), r.elementBytes + r.slackBytes + r.tableBytes + r.controlBlockBytes
+                         + r.figureHeapBytes + r.allocatorOverheadBytes);
+
+    Array<Square<double>> values;
+    Square<double> s;
+    inputFigure(s, "0 0  1 0  1 1  0 1");
+    values.add(s);
+    MemoryReport v = values.memoryReport();
+    EXPECT_EQ(v.elementBytes, sizeof(Square<double>));
+    EXPECT_EQ(v.figureHeapBytes, Array<Square<double>>::ChunkSize * 4 * sizeof(Point<double>));
+}
+
+TEST(MemoryTest, ValueReportMatchesGlobalHeap) {
+    Square<double> s;
+    inputFigure(s, "0 0  1 0  1 1  0 1");
+    size_t before = heapLiveBytes.load();
+    {
+        Array<Square<double>> values;
+        values.add(s);
+        MemoryReport r = values.memoryReport();
+        EXPECT_EQ(r.total() - r.allocatorOverheadBytes, heapLiveBytes.load() - before);
+
+        // remove() ставит в освободившийся слот Square{}, который снова выделяет вершины.
+        values.add(s);
+        values.remove(0);
+        r = values.memoryReport();
+        EXPECT_EQ(r.total() - r.allocatorOverheadBytes, heapLiveBytes.load() - before);
+    }
+    EXPECT_EQ(heapLiveBytes.load(), before);
+}
+
+TEST(MemoryTest, CountingAllocatorTracksArrayOperations) {
+    AllocationCounts counts;
+    using Counted = Array<int, CountingAllocator<int>>;
+    Counted arr{CountingAllocator<int>(&counts)};
+    EXPECT_EQ(counts.allocations.load(), 2);  // таблица и первый чанк
+
+    for (int i = 0; i < int(Counted::ChunkSize); ++i) arr.add(i);
+    EXPECT_EQ(counts.allocations.load(), 2);
+    arr.add(-1);                               // новый чанк
+    EXPECT_EQ(counts.allocations.load(), 3);
+    while (arr.getSize() < 4 * Counted::ChunkSize) arr.add(0);
+    EXPECT_EQ(counts.allocations.load(), 5);
+    arr.add(1);                                // удвоение таблицы и чанк
+    EXPECT_EQ(counts.allocations.load(), 7);
+
+    Counted copy = arr;
+    auto snap = arr.snapshot();
+    EXPECT_EQ(counts.allocations.load(), 7);
+    copy[3] = 42;                              // копия таблицы и одного чанка
+    EXPECT_EQ(counts.allocations.load(), 9);
+
+    Counted moved = std::move(copy);
+    EXPECT_EQ(counts.allocations.load(), 9);
+    EXPECT_EQ(moved[3], 42);
+    EXPECT_EQ(snap[3], 3);
+
+    size_t live = counts.liveBytes.load();
+    {
+        Counted scratch{CountingAllocator<int>(&counts)};
+        EXPECT_GT(counts.liveBytes.load(), live);
+    }
+    EXPECT_EQ(counts.liveBytes.load(), live);
+    // Живы: таблица и 5 чанков arr, таблица и чанк moved; старая таблица освобождена.
+    EXPECT_EQ(counts.allocations.load() - counts.deallocations.load(), 8);
+
+    EXPECT_EQ(copy.getSize(), 0);
+    MemoryReport empty = copy.memoryReport();
+    EXPECT_EQ(empty.total(), 0);
+    copy.add(7);
+    EXPECT_EQ(copy[0], 7);
+}
+
+TEST(MemoryTest, ReportMatchesBytesRequestedFromAllocator) {
+    AllocationCounts counts;
+    using Counted = Array<int, CountingAllocator<int>>;
+    Counted arr{CountingAllocator<int>(&counts)};
+    for (int i = 0; i < 300; ++i) arr.add(i);
+
+    // Копия аллокатора в блоке управления увеличивает его на sizeof(CountingAllocator).
+    MemoryReport r = arr.memoryReport();
+    EXPECT_EQ(r.elementBytes + r.slackBytes + r.tableBytes + r.controlBlockBytes, counts.liveBytes.load());
+    EXPECT_EQ(sharedArrayControlBytes<int>(CountingAllocator<int>(&counts)),
+              sharedArrayControlBytes<int>(std::allocator<int>()) + sizeof(CountingAllocator<int>));
+}
+
 // --- MAIN ---
 int main(int argc, char **argv) {
+    if (ShardedFigures::runWorkerFromArgs(argc, argv)) return 0;
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }